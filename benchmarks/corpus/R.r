@@ -0,0 +1,26 @@
+# Summary statistics of a simulated sample
+set.seed(42)
+n <- 1000L
+x <- rnorm(n, mean = 10, sd = 2.5)
+y <- 3.2 * x + rnorm(n, sd = 0.5)
+
+fit <- lm(y ~ x)
+summary(fit)
+
+describe <- function(v, na.rm = TRUE) {
+  if (!is.numeric(v)) stop("expected a numeric vector")
+  c(mean = mean(v, na.rm = na.rm),
+    median = median(v, na.rm = na.rm),
+    sd = sd(v, na.rm = na.rm))
+}
+
+stats <- sapply(list(x = x, y = y), describe)
+print(stats)
+
+for (i in seq_len(5)) {
+  cat(sprintf("sample %d: %.3f\n", i, x[i]))
+}
+
+df <- data.frame(x = x, y = y, group = factor(x > 10, labels = c("low", "high")))
+aggregate(y ~ group, data = df, FUN = mean)
+while (FALSE) NULL
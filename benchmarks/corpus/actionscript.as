@@ -0,0 +1,34 @@
+package com.example.game
+{
+    import flash.display.Sprite;
+    import flash.events.Event;
+
+    /**
+     * A ball bouncing inside the stage.
+     */
+    public class Ball extends Sprite
+    {
+        private static const GRAVITY:Number = 0.5;
+        private var velocity:Number = 0;
+        public var radius:int = 12;
+
+        public function Ball(color:uint = 0xFF3300)
+        {
+            graphics.beginFill(color);
+            graphics.drawCircle(0, 0, radius);
+            graphics.endFill();
+            addEventListener(Event.ENTER_FRAME, onFrame);
+        }
+
+        private function onFrame(event:Event):void
+        {
+            velocity += GRAVITY;
+            y += velocity;
+            if (y + radius > stage.stageHeight) {
+                y = stage.stageHeight - radius;
+                velocity *= -0.8; // lose some energy
+            }
+            trace("y = " + y);
+        }
+    }
+}
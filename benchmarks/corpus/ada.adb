@@ -0,0 +1,33 @@
+with Ada.Text_IO; use Ada.Text_IO;
+with Ada.Integer_Text_IO;
+
+procedure Primes is
+   -- Sieve of Eratosthenes up to Limit
+   Limit : constant Positive := 100;
+   type Flags is array (2 .. Limit) of Boolean;
+   Is_Prime : Flags := (others => True);
+   Count    : Natural := 0;
+begin
+   for I in Is_Prime'Range loop
+      if Is_Prime (I) then
+         Count := Count + 1;
+         declare
+            J : Positive := I * I;
+         begin
+            while J <= Limit loop
+               Is_Prime (J) := False;
+               J := J + I;
+            end loop;
+         end;
+      end if;
+   end loop;
+
+   Put ("Primes below ");
+   Ada.Integer_Text_IO.Put (Limit, Width => 0);
+   Put (": ");
+   Ada.Integer_Text_IO.Put (Count, Width => 0);
+   New_Line;
+exception
+   when Constraint_Error =>
+      Put_Line ("overflow");
+end Primes;
@@ -0,0 +1,37 @@
+#!/usr/bin/awk -f
+# Word frequencies of the input, most frequent first
+BEGIN {
+    FS = "[^A-Za-z]+"
+    total = 0
+}
+
+{
+    for (i = 1; i <= NF; i++) {
+        word = tolower($i)
+        if (length(word) < 3)
+            continue
+        count[word]++
+        total++
+    }
+}
+
+/^#/ { comments++ }
+
+END {
+    n = 0
+    for (w in count)
+        words[++n] = w
+    # simple insertion sort by count
+    for (i = 2; i <= n; i++) {
+        v = words[i]
+        j = i - 1
+        while (j > 0 && count[words[j]] < count[v]) {
+            words[j + 1] = words[j]
+            j--
+        }
+        words[j + 1] = v
+    }
+    for (i = 1; i <= n && i <= 10; i++)
+        printf "%-20s %6d %5.1f%%\n", words[i], count[words[i]], 100 * count[words[i]] / total
+    print "comment lines:", comments + 0
+}
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_WORDS 1024
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/* A word and the number of times it occurs */
+struct entry {
+    char *word;
+    unsigned long count;
+};
+
+static int compare(const void *a, const void *b)
+{
+    const struct entry *x = a, *y = b;
+    if (x->count != y->count)
+        return x->count < y->count ? 1 : -1;
+    return strcmp(x->word, y->word);
+}
+
+int main(int argc, char **argv)
+{
+    struct entry entries[MAX_WORDS];
+    size_t n = 0;
+    char buffer[256];
+
+    while (scanf("%255s", buffer) == 1 && n < MAX_WORDS) {
+        size_t i;
+        for (i = 0; i < n; i++) {
+            if (strcmp(entries[i].word, buffer) == 0)
+                break;
+        }
+        if (i == n) {
+            entries[n].word = strdup(buffer);
+            entries[n++].count = 0;
+        }
+        entries[i].count++;
+    }
+
+    qsort(entries, n, sizeof(*entries), compare);
+    for (size_t i = 0; i < MIN(n, 10); i++)
+        printf("%-20s %lu\n", entries[i].word, entries[i].count);
+    // Not freed, the process ends here
+    return argc > 1 ? EXIT_FAILURE : 0x0;
+}
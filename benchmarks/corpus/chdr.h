@@ -0,0 +1,44 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A fixed size queue of bytes, safe for one reader and one writer */
+typedef struct ring_buffer {
+    unsigned char *data;
+    size_t capacity;
+    volatile size_t head;
+    volatile size_t tail;
+} ring_buffer;
+
+#define RING_BUFFER_INIT(storage) { (storage), sizeof(storage), 0, 0 }
+
+bool ring_buffer_push(ring_buffer *buffer, unsigned char byte);
+bool ring_buffer_pop(ring_buffer *buffer, unsigned char *byte);
+
+static inline size_t ring_buffer_size(const ring_buffer *buffer)
+{
+    return (buffer->head + buffer->capacity - buffer->tail) % buffer->capacity;
+}
+
+static inline bool ring_buffer_empty(const ring_buffer *buffer)
+{
+    return buffer->head == buffer->tail; // nothing queued
+}
+
+enum ring_buffer_error {
+    RING_BUFFER_OK = 0,
+    RING_BUFFER_FULL = -1,
+    RING_BUFFER_EMPTY = -2
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RING_BUFFER_H */
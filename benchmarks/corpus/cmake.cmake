@@ -0,0 +1,35 @@
+cmake_minimum_required(VERSION 3.10)
+project(Example VERSION 1.2.0 LANGUAGES C CXX)
+
+option(EXAMPLE_WITH_TESTS "Build the tests" ON)
+set(CMAKE_CXX_STANDARD 14)
+set(CMAKE_CXX_STANDARD_REQUIRED ON)
+
+# Sources of the library
+set(example_SOURCES
+    src/parser.cpp
+    src/lexer.cpp
+    src/main.cpp
+)
+
+find_package(Qt5 5.10 REQUIRED COMPONENTS Core Gui)
+
+add_library(example STATIC ${example_SOURCES})
+target_include_directories(example PUBLIC "${CMAKE_CURRENT_SOURCE_DIR}/include")
+target_link_libraries(example PUBLIC Qt5::Core Qt5::Gui)
+
+if(EXAMPLE_WITH_TESTS AND NOT CMAKE_CROSSCOMPILING)
+    enable_testing()
+    foreach(test parser lexer)
+        add_executable(test_${test} tests/test_${test}.cpp)
+        target_link_libraries(test_${test} PRIVATE example)
+        add_test(NAME ${test} COMMAND test_${test})
+    endforeach()
+endif()
+
+function(example_message text)
+    message(STATUS "[example] ${text}")
+endfunction()
+
+example_message("Version ${PROJECT_VERSION}")
+install(TARGETS example DESTINATION lib)
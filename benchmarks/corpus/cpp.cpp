@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace shapes {
+
+// Base of all shapes
+class Shape
+{
+public:
+    virtual ~Shape() = default;
+    virtual double area() const = 0;
+    virtual std::string name() const { return "shape"; }
+};
+
+class Circle : public Shape
+{
+public:
+    explicit Circle(double radius) : m_radius(radius) {}
+    double area() const override { return 3.14159265358979 * m_radius * m_radius; }
+    std::string name() const override { return "circle"; }
+
+private:
+    double m_radius;
+};
+
+template <typename T>
+class Rectangle final : public Shape
+{
+public:
+    Rectangle(T width, T height) : m_width(width), m_height(height) {}
+    double area() const override { return static_cast<double>(m_width * m_height); }
+    std::string name() const override { return "rectangle"; }
+
+private:
+    T m_width, m_height;
+};
+
+} // namespace shapes
+
+int main()
+{
+    std::vector<std::unique_ptr<shapes::Shape>> all;
+    all.push_back(std::make_unique<shapes::Circle>(1.5));
+    all.push_back(std::make_unique<shapes::Rectangle<int>>(3, 4));
+
+    std::sort(all.begin(), all.end(), [](const auto &a, const auto &b) {
+        return a->area() < b->area();
+    });
+
+    std::map<std::string, double> totals;
+    for (const auto &shape : all)
+        totals[shape->name()] += shape->area();
+
+    /* Print the totals */
+    for (const auto &entry : totals)
+        std::cout << entry.first << ": " << entry.second << '\n';
+    return totals.empty() ? 1 : 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+namespace util {
+
+/* A vector with a fixed capacity, stored inline */
+template <typename T, std::size_t N>
+class StaticVector
+{
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    StaticVector() noexcept = default;
+    ~StaticVector() { clear(); }
+
+    template <typename... Args>
+    T &emplace_back(Args &&... args)
+    {
+        if (m_size == N)
+            throw std::length_error("StaticVector is full");
+        T *item = new (&m_storage[m_size]) T(std::forward<Args>(args)...);
+        ++m_size;
+        return *item;
+    }
+
+    void clear() noexcept
+    {
+        while (m_size > 0)
+            data()[--m_size].~T();
+    }
+
+    T *data() noexcept { return reinterpret_cast<T *>(m_storage); }
+    size_type size() const noexcept { return m_size; }
+    constexpr size_type capacity() const noexcept { return N; }
+    T &operator[](size_type i) { return data()[i]; }
+
+private:
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage[N];
+    size_type m_size = 0; // number of constructed items
+};
+
+} // namespace util
@@ -0,0 +1,40 @@
+using System;
+using System.Collections.Generic;
+using System.Linq;
+
+namespace Example.Inventory
+{
+    /// <summary>An item in stock.</summary>
+    public record Item(string Name, decimal Price, int Quantity);
+
+    public class Inventory
+    {
+        private readonly List<Item> _items = new List<Item>();
+
+        public void Add(Item item)
+        {
+            if (item == null) throw new ArgumentNullException(nameof(item));
+            _items.Add(item);
+        }
+
+        public decimal TotalValue => _items.Sum(i => i.Price * i.Quantity);
+
+        public IEnumerable<Item> LowStock(int threshold = 5) =>
+            from i in _items where i.Quantity < threshold orderby i.Name select i;
+    }
+
+    public static class Program
+    {
+        public static int Main(string[] args)
+        {
+            var inventory = new Inventory();
+            inventory.Add(new Item("bolt", 0.10m, 250));
+            inventory.Add(new Item("hinge", 2.50m, 3));
+            // Report the items running low
+            foreach (var item in inventory.LowStock())
+                Console.WriteLine($"{item.Name}: only {item.Quantity} left");
+            Console.WriteLine("Total: {0:C}", inventory.TotalValue);
+            return args.Length > 0 ? 1 : 0;
+        }
+    }
+}
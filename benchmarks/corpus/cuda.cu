@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <cuda_runtime.h>
+
+// y = a * x + y on the device
+__global__ void saxpy(int n, float a, const float *__restrict__ x, float *__restrict__ y)
+{
+    int i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i < n)
+        y[i] = a * x[i] + y[i];
+}
+
+__device__ float square(float v) { return v * v; }
+
+__global__ void sumOfSquares(const float *data, float *result, int n)
+{
+    __shared__ float cache[256];
+    int tid = threadIdx.x;
+    cache[tid] = tid < n ? square(data[tid]) : 0.0f;
+    __syncthreads();
+    for (int s = blockDim.x / 2; s > 0; s >>= 1) {
+        if (tid < s)
+            cache[tid] += cache[tid + s];
+        __syncthreads();
+    }
+    if (tid == 0)
+        atomicAdd(result, cache[0]);
+}
+
+int main()
+{
+    const int n = 1 << 20;
+    float *x, *y;
+    cudaMallocManaged(&x, n * sizeof(float));
+    cudaMallocManaged(&y, n * sizeof(float));
+    for (int i = 0; i < n; ++i) {
+        x[i] = 1.0f;
+        y[i] = 2.0f;
+    }
+    saxpy<<<(n + 255) / 256, 256>>>(n, 2.0f, x, y);
+    cudaDeviceSynchronize();
+    printf("y[0] = %f\n", y[0]);
+    cudaFree(x);
+    cudaFree(y);
+    return 0;
+}
@@ -0,0 +1,31 @@
+@echo off
+rem Build and package the application
+setlocal enabledelayedexpansion
+
+set BUILD_DIR=%~dp0build
+set CONFIG=Release
+if "%1"=="debug" set CONFIG=Debug
+
+if not exist "%BUILD_DIR%" mkdir "%BUILD_DIR%"
+pushd "%BUILD_DIR%"
+
+cmake .. -G "NMake Makefiles" -DCMAKE_BUILD_TYPE=%CONFIG%
+if errorlevel 1 goto :error
+
+nmake
+if %ERRORLEVEL% neq 0 goto :error
+
+:: copy the runtime files
+for %%f in (*.dll *.exe) do (
+    echo Copying %%f
+    copy /y "%%f" "..\dist\" > nul
+    set /a COUNT+=1
+)
+echo Copied !COUNT! files
+popd
+goto :eof
+
+:error
+echo Build failed with %ERRORLEVEL%
+popd
+exit /b 1
@@ -0,0 +1,51 @@
+note
+    description: "A bank account with a balance that never goes negative"
+    author: "Jane Doe"
+
+class
+    ACCOUNT
+
+create
+    make
+
+feature {NONE} -- Initialization
+
+    make (an_owner: STRING)
+            -- Open an account for `an_owner'.
+        require
+            owner_not_empty: not an_owner.is_empty
+        do
+            owner := an_owner
+            balance := 0
+        ensure
+            owner_set: owner = an_owner
+        end
+
+feature -- Access
+
+    owner: STRING
+    balance: INTEGER
+
+feature -- Operations
+
+    deposit (amount: INTEGER)
+        require
+            positive: amount > 0
+        do
+            balance := balance + amount
+        ensure
+            increased: balance = old balance + amount
+        end
+
+    withdraw (amount: INTEGER)
+        require
+            positive: amount > 0
+            enough: amount <= balance
+        do
+            balance := balance - amount
+        end
+
+invariant
+    never_negative: balance >= 0
+
+end
@@ -0,0 +1,36 @@
+%% A counter process
+-module(counter).
+-export([start/0, increment/1, value/1, loop/1]).
+-define(TIMEOUT, 5000).
+
+-record(state, {count = 0 :: non_neg_integer(), name = "counter" :: string()}).
+
+start() ->
+    spawn(?MODULE, loop, [#state{}]).
+
+increment(Pid) ->
+    Pid ! {increment, 1},
+    ok.
+
+value(Pid) ->
+    Pid ! {value, self()},
+    receive
+        {value, N} -> {ok, N}
+    after ?TIMEOUT ->
+        {error, timeout}
+    end.
+
+loop(#state{count = Count} = State) ->
+    receive
+        {increment, By} when is_integer(By), By > 0 ->
+            loop(State#state{count = Count + By});
+        {value, From} ->
+            From ! {value, Count},
+            loop(State);
+        stop ->
+            io:format("stopping at ~p~n", [Count]),
+            ok;
+        Other ->
+            error_logger:warning_msg("unexpected ~p~n", [Other]),
+            loop(State)
+    end.
@@ -0,0 +1,51 @@
+! Numerical integration with the trapezoidal rule
+module integration
+    implicit none
+    private
+    public :: trapezoid
+
+    integer, parameter, public :: dp = kind(1.0d0)
+
+contains
+
+    function trapezoid(f, a, b, n) result(area)
+        interface
+            real(dp) function f(x)
+                import :: dp
+                real(dp), intent(in) :: x
+            end function f
+        end interface
+        real(dp), intent(in) :: a, b
+        integer, intent(in) :: n
+        real(dp) :: area, h
+        integer :: i
+
+        h = (b - a) / real(n, dp)
+        area = 0.5_dp * (f(a) + f(b))
+        do i = 1, n - 1
+            area = area + f(a + i * h)
+        end do
+        area = area * h
+    end function trapezoid
+
+end module integration
+
+program main
+    use integration
+    implicit none
+    real(dp) :: result
+
+    result = trapezoid(parabola, 0.0_dp, 1.0_dp, 1000)
+    write (*, '(A, F10.6)') 'Integral: ', result
+    if (abs(result - 1.0_dp / 3.0_dp) > 1.0e-5_dp) then
+        print *, "inaccurate"
+    end if
+
+contains
+
+    real(dp) function parabola(x)
+        real(dp), intent(in) :: x
+        parabola = x**2
+    end function parabola
+
+end program main
@@ -0,0 +1,34 @@
+module Example.Shapes
+
+open System
+
+/// A shape in the plane
+type Shape =
+    | Circle of radius: float
+    | Rectangle of width: float * height: float
+    | Triangle of a: float * b: float * c: float
+
+let area shape =
+    match shape with
+    | Circle r -> Math.PI * r * r
+    | Rectangle (w, h) -> w * h
+    | Triangle (a, b, c) ->
+        // Heron's formula
+        let s = (a + b + c) / 2.0
+        sqrt (s * (s - a) * (s - b) * (s - c))
+
+(* Some shapes to try *)
+let shapes =
+    [ Circle 1.0
+      Rectangle (2.0, 3.5)
+      Triangle (3.0, 4.0, 5.0) ]
+
+let total = shapes |> List.sumBy area
+
+[<EntryPoint>]
+let main argv =
+    for shape in shapes do
+        printfn "%A has area %.2f" shape (area shape)
+    printfn "Total: %f" total
+    let largest = shapes |> List.maxBy area
+    if argv.Length > 0 then 1 else 0
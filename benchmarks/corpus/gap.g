@@ -0,0 +1,31 @@
+# Orders of the elements of a symmetric group
+G := SymmetricGroup(5);
+Print("Size: ", Size(G), "\n");
+
+orders := List(ConjugacyClasses(G), c -> Order(Representative(c)));
+Print(Collected(orders), "\n");
+
+IsAbelianish := function(H)
+    local x, y;
+    for x in GeneratorsOfGroup(H) do
+        for y in GeneratorsOfGroup(H) do
+            if x * y <> y * x then
+                return false;
+            fi;
+        od;
+    od;
+    return true;
+end;
+
+A := AlternatingGroup(5);
+if IsSimple(A) and not IsAbelianish(A) then
+    Print("A5 is simple and not abelian\n");
+fi;
+
+## the subgroups of order 12
+subs := Filtered(List(ConjugacyClassesSubgroups(G), Representative), H -> Size(H) = 12);
+for H in subs do
+    Print(StructureDescription(H), "\n");
+od;
+x := (1,2,3)(4,5);
+Print(Order(x), " ", x^2, "\n");
@@ -0,0 +1,35 @@
+[indent=4]
+/* A small Genie program */
+uses
+    GLib
+
+class Greeter : Object
+    prop name : string = "World"
+    count : int = 0
+
+    construct (name : string)
+        self.name = name
+
+    def greet () : string
+        count++
+        return "Hello, %s! (%d)".printf (name, count)
+
+def sum (values : array of int) : int
+    var total = 0
+    for v in values
+        total += v
+    return total
+
+init
+    var greeter = new Greeter ("Genie")
+    print greeter.greet ()
+    var numbers = {1, 2, 3, 4, 5}
+    print "sum: %d", sum (numbers)
+    // loops and conditions
+    for var i = 0 to 3
+        if i % 2 == 0
+            print "%d is even", i
+        else
+            print "%d is odd", i
+    while false
+        pass
@@ -0,0 +1,52 @@
+// Command wordcount counts the words read from standard input.
+package main
+
+import (
+	"bufio"
+	"fmt"
+	"os"
+	"sort"
+	"strings"
+)
+
+type entry struct {
+	word  string
+	count int
+}
+
+func count(scanner *bufio.Scanner) map[string]int {
+	counts := make(map[string]int)
+	for scanner.Scan() {
+		for _, word := range strings.Fields(scanner.Text()) {
+			counts[strings.ToLower(word)]++
+		}
+	}
+	return counts
+}
+
+func main() {
+	scanner := bufio.NewScanner(os.Stdin)
+	counts := count(scanner)
+	if err := scanner.Err(); err != nil {
+		fmt.Fprintln(os.Stderr, "read error:", err)
+		os.Exit(1)
+	}
+
+	entries := make([]entry, 0, len(counts))
+	for w, c := range counts {
+		entries = append(entries, entry{w, c})
+	}
+	sort.Slice(entries, func(i, j int) bool {
+		return entries[i].count > entries[j].count
+	})
+	/* print the top ten */
+	for i, e := range entries {
+		if i >= 10 {
+			break
+		}
+		fmt.Printf("%-20s %d\n", e.word, e.count)
+	}
+	const pi = 3.14159
+	var raw = `raw string\n`
+	_ = raw
+}
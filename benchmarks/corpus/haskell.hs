@@ -0,0 +1,47 @@
+{-# LANGUAGE ScopedTypeVariables #-}
+-- | A binary search tree
+module Tree
+  ( Tree (..)
+  , insert
+  , member
+  , fromList
+  , toList
+  ) where
+
+import Data.List (foldl')
+import qualified Data.Map as Map
+
+data Tree a = Leaf | Node (Tree a) a (Tree a)
+  deriving (Show, Eq)
+
+insert :: Ord a => a -> Tree a -> Tree a
+insert x Leaf = Node Leaf x Leaf
+insert x t@(Node l v r)
+  | x < v = Node (insert x l) v r
+  | x > v = Node l v (insert x r)
+  | otherwise = t
+
+member :: Ord a => a -> Tree a -> Bool
+member _ Leaf = False
+member x (Node l v r) = case compare x v of
+  LT -> member x l
+  GT -> member x r
+  EQ -> True
+
+fromList :: Ord a => [a] -> Tree a
+fromList = foldl' (flip insert) Leaf
+
+toList :: Tree a -> [a]
+toList Leaf = []
+toList (Node l v r) = toList l ++ [v] ++ toList r
+
+{- Frequencies of the letters of a string -}
+frequencies :: String -> Map.Map Char Int
+frequencies = Map.fromListWith (+) . map (\c -> (c, 1))
+
+main :: IO ()
+main = do
+  let t = fromList [5, 3, 8, 1, 4 :: Int]
+  print (toList t)
+  print (member 4 t, member 7 t)
+  print $ frequencies "hello world"
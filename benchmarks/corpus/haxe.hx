@@ -0,0 +1,46 @@
+package example;
+
+import haxe.ds.StringMap;
+
+/**
+ * A simple event dispatcher.
+ */
+class Dispatcher<T> {
+    var listeners:StringMap<Array<T->Void>>;
+
+    public function new() {
+        listeners = new StringMap();
+    }
+
+    public function on(event:String, listener:T->Void):Void {
+        if (!listeners.exists(event))
+            listeners.set(event, []);
+        listeners.get(event).push(listener);
+    }
+
+    public function emit(event:String, value:T):Int {
+        var called = 0;
+        for (listener in listeners.get(event) ?? []) {
+            listener(value);
+            called++;
+        }
+        return called;
+    }
+}
+
+class Main {
+    static inline var VERSION = "1.0";
+
+    static function main() {
+        var d = new Dispatcher<Int>();
+        d.on("tick", function(n) trace('tick $n'));
+        d.on("tick", n -> if (n % 2 == 0) trace("even"));
+        for (i in 0...3) d.emit("tick", i);
+        // switch on an enum
+        var color = switch (Std.random(2)) {
+            case 0: "red";
+            default: "blue";
+        }
+        trace('Version ${VERSION}, color $color, hex ${0xFF}');
+    }
+}
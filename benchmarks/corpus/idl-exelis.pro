@@ -0,0 +1,28 @@
+; Smooths a noisy signal and plots it
+function moving_average, data, width
+  compile_opt idl2
+  if n_params() lt 2 then width = 5
+  n = n_elements(data)
+  result = fltarr(n)
+  for i = 0L, n - 1 do begin
+    lo = (i - width / 2) > 0
+    hi = (i + width / 2) < (n - 1)
+    result[i] = mean(data[lo:hi])
+  endfor
+  return, result
+end
+
+pro demo_smooth, width=width
+  compile_opt idl2
+  if ~keyword_set(width) then width = 7
+  x = findgen(200) / 10.0
+  signal = sin(x) + 0.3 * randomn(seed, 200)
+  smoothed = moving_average(signal, width)
+  p = plot(x, signal, color='gray', title="Signal")
+  p2 = plot(x, smoothed, color='red', thick=2, /overplot)
+  print, 'RMS error: ', sqrt(mean((smoothed - sin(x))^2))
+  case width of
+    3: print, 'narrow'
+    else: print, 'wide'
+  endcase
+end
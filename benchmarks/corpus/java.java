@@ -0,0 +1,52 @@
+package org.example.bank;
+
+import java.math.BigDecimal;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.Objects;
+
+/**
+ * An account which keeps its transactions.
+ *
+ * @author Jane Doe
+ */
+public class Account implements Comparable<Account> {
+    private static final BigDecimal LIMIT = new BigDecimal("10000.00");
+
+    private final String owner;
+    private final List<BigDecimal> transactions = new ArrayList<>();
+    private BigDecimal balance = BigDecimal.ZERO;
+
+    public Account(String owner) {
+        this.owner = Objects.requireNonNull(owner, "owner");
+    }
+
+    public synchronized void deposit(BigDecimal amount) {
+        if (amount.signum() <= 0 || amount.compareTo(LIMIT) > 0) {
+            throw new IllegalArgumentException("invalid amount: " + amount);
+        }
+        transactions.add(amount);
+        balance = balance.add(amount);
+    }
+
+    public List<BigDecimal> getTransactions() {
+        return Collections.unmodifiableList(transactions);
+    }
+
+    @Override
+    public int compareTo(Account other) {
+        return balance.compareTo(other.balance);
+    }
+
+    public static void main(String[] args) throws Exception {
+        Account account = new Account("Jane");
+        for (int i = 1; i <= 3; i++) {
+            account.deposit(BigDecimal.valueOf(i * 10.5));
+        }
+        // prints the balance
+        System.out.printf("%s has %s%n", account.owner, account.balance);
+        char c = 'x';
+        long big = 0x7fffffffL;
+    }
+}
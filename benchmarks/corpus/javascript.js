@@ -0,0 +1,48 @@
+'use strict';
+
+/**
+ * Debounces a function, so it runs once calls stop for `wait` milliseconds.
+ */
+function debounce(fn, wait = 100) {
+    let timer = null;
+    return function (...args) {
+        clearTimeout(timer);
+        timer = setTimeout(() => fn.apply(this, args), wait);
+    };
+}
+
+class Store {
+    constructor(initial = {}) {
+        this.state = { ...initial };
+        this.listeners = new Set();
+    }
+
+    subscribe(listener) {
+        this.listeners.add(listener);
+        return () => this.listeners.delete(listener);
+    }
+
+    async update(changes) {
+        this.state = Object.assign({}, this.state, changes);
+        for (const listener of this.listeners) {
+            await listener(this.state);
+        }
+    }
+}
+
+const store = new Store({ count: 0 });
+const log = debounce(state => console.log(`count is ${state.count}`), 50);
+store.subscribe(log);
+
+// increment a few times
+for (let i = 0; i < 3; i++) {
+    store.update({ count: store.state.count + 1 });
+}
+
+const pattern = /^[a-z]+\d*$/gi;
+if (pattern.test('abc123') && typeof store === 'object') {
+    fetch('/api/items')
+        .then(response => response.json())
+        .catch(error => console.error(error));
+}
+export default Store;
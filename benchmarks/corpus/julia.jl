@@ -0,0 +1,41 @@
+# Monte Carlo estimate of pi
+module PiEstimate
+
+export estimate, Point
+
+struct Point{T<:Real}
+    x::T
+    y::T
+end
+
+inside(p::Point) = p.x^2 + p.y^2 <= 1
+
+"""
+    estimate(n)
+
+Estimate pi from `n` random points.
+"""
+function estimate(n::Integer)
+    hits = 0
+    for _ in 1:n
+        p = Point(rand(), rand())
+        if inside(p)
+            hits += 1
+        end
+    end
+    return 4 * hits / n
+end
+
+end # module
+
+using .PiEstimate
+
+for n in (100, 10_000, 1_000_000)
+    est = estimate(n)
+    println("n = $n: ", est, " (error ", abs(est - pi), ")")
+end
+
+squares = [x^2 for x in 1:10 if isodd(x)]
+@assert length(squares) == 5
+m = [1 2; 3 4]
+println(m * m', " ", 0x1f, " ", 'c')
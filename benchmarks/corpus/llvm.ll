@@ -0,0 +1,35 @@
+; ModuleID = 'sum.c'
+source_filename = "sum.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@.str = private unnamed_addr constant [8 x i8] c"sum %d\0A\00", align 1
+
+; Sums the first n integers
+define i32 @sum(i32 %n) #0 {
+entry:
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %next, %loop ]
+  %acc = phi i32 [ 0, %entry ], [ %add, %loop ]
+  %add = add nsw i32 %acc, %i
+  %next = add nuw nsw i32 %i, 1
+  %done = icmp eq i32 %next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %result = phi i32 [ 0, %entry ], [ %add, %loop ]
+  ret i32 %result
+}
+
+define i32 @main() {
+  %1 = call i32 @sum(i32 100)
+  %2 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([8 x i8], [8 x i8]* @.str, i64 0, i64 0), i32 %1)
+  ret i32 0
+}
+
+declare i32 @printf(i8*, ...)
+
+attributes #0 = { nounwind readnone }
@@ -0,0 +1,44 @@
+-- A simple class with metatables
+local Stack = {}
+Stack.__index = Stack
+
+function Stack.new()
+  return setmetatable({ items = {}, size = 0 }, Stack)
+end
+
+function Stack:push(value)
+  self.size = self.size + 1
+  self.items[self.size] = value
+end
+
+function Stack:pop()
+  if self.size == 0 then
+    return nil, "empty stack"
+  end
+  local value = self.items[self.size]
+  self.items[self.size] = nil
+  self.size = self.size - 1
+  return value
+end
+
+--[[ Evaluates an expression in
+     reverse polish notation ]]
+local function rpn(expression)
+  local stack = Stack.new()
+  for token in expression:gmatch("%S+") do
+    local n = tonumber(token)
+    if n then
+      stack:push(n)
+    else
+      local b, a = stack:pop(), stack:pop()
+      if token == "+" then stack:push(a + b)
+      elseif token == "-" then stack:push(a - b)
+      elseif token == "*" then stack:push(a * b)
+      else stack:push(a / b) end
+    end
+  end
+  return stack:pop()
+end
+
+print(rpn("3 4 + 2 *"), [[long string]], 0x10, 1e3)
+for i, v in ipairs({ "a", "b" }) do print(i, v) end
@@ -0,0 +1,28 @@
+dnl Process this file with autoconf to produce a configure script.
+AC_PREREQ([2.69])
+AC_INIT([hello], [1.2.0], [bugs@example.org])
+AC_CONFIG_SRCDIR([src/main.c])
+AC_CONFIG_HEADERS([config.h])
+AM_INIT_AUTOMAKE([foreign -Wall -Werror])
+
+# Checks for programs.
+AC_PROG_CC
+LT_INIT
+
+# Checks for libraries.
+PKG_CHECK_MODULES([GLIB], [glib-2.0 >= 2.40])
+
+AC_ARG_ENABLE([tests],
+  [AS_HELP_STRING([--enable-tests], [build the tests @<:@default=yes@:>@])],
+  [enable_tests=$enableval],
+  [enable_tests=yes])
+AM_CONDITIONAL([ENABLE_TESTS], [test "x$enable_tests" = "xyes"])
+
+define([GREETING], [Hello, world])
+AC_DEFINE([DEFAULT_GREETING], ["GREETING"], [The default greeting])
+
+AC_CHECK_HEADERS([stdlib.h string.h unistd.h])
+AC_CHECK_FUNCS([strdup strndup], [], [AC_MSG_WARN([missing $ac_func])])
+
+AC_CONFIG_FILES([Makefile lib/Makefile src/Makefile tests/Makefile])
+AC_OUTPUT
@@ -0,0 +1,34 @@
+# Build the example program
+CC ?= gcc
+CFLAGS ?= -O2 -g
+CFLAGS += -Wall -Wextra -std=c11
+LDLIBS = -lm
+PREFIX := /usr/local
+
+SOURCES := $(wildcard src/*.c)
+OBJECTS := $(SOURCES:.c=.o)
+TARGET = example
+
+.PHONY: all clean install
+
+all: $(TARGET)
+
+$(TARGET): $(OBJECTS)
+	$(CC) $(LDFLAGS) -o $@ $^ $(LDLIBS)
+
+%.o: %.c src/config.h
+	$(CC) $(CFLAGS) -c -o $@ $<
+
+src/config.h: config.h.in
+	sed -e 's|@PREFIX@|$(PREFIX)|g' $< > $@
+
+install: $(TARGET)
+	install -d $(DESTDIR)$(PREFIX)/bin
+	install -m 755 $(TARGET) $(DESTDIR)$(PREFIX)/bin/
+
+clean:
+	$(RM) $(OBJECTS) $(TARGET) src/config.h
+
+ifeq ($(DEBUG),1)
+CFLAGS += -O0 -DDEBUG
+endif
@@ -0,0 +1,30 @@
+% Solves a linear system and plots the residuals
+function residuals = solve_demo(n)
+    if nargin < 1
+        n = 50;
+    end
+    A = rand(n) + n * eye(n);   % diagonally dominant
+    b = ones(n, 1);
+    x = A \ b;
+
+    % Jacobi iteration for comparison
+    D = diag(diag(A));
+    R = A - D;
+    y = zeros(n, 1);
+    residuals = zeros(1, 100);
+    for k = 1:100
+        y = D \ (b - R * y);
+        residuals(k) = norm(A * y - b);
+        if residuals(k) < 1e-10
+            residuals = residuals(1:k);
+            break;
+        end
+    end
+
+    fprintf('direct: %g, jacobi: %g after %d steps\n', ...
+            norm(A * x - b), residuals(end), numel(residuals));
+    semilogy(residuals, 'r-', 'LineWidth', 2);
+    title('Residuals of the Jacobi iteration');
+    names = {'direct', 'jacobi'};
+    s = struct('n', n, 'method', 'jacobi');
+end
@@ -0,0 +1,45 @@
+#import <Foundation/Foundation.h>
+
+/* A person with a name and an age */
+@interface Person : NSObject
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, assign) NSInteger age;
+- (instancetype)initWithName:(NSString *)name age:(NSInteger)age;
+- (NSString *)greeting;
+@end
+
+@implementation Person
+
+- (instancetype)initWithName:(NSString *)name age:(NSInteger)age
+{
+    self = [super init];
+    if (self) {
+        _name = [name copy];
+        _age = age;
+    }
+    return self;
+}
+
+- (NSString *)greeting
+{
+    return [NSString stringWithFormat:@"Hello, I'm %@ (%ld)", self.name, (long)self.age];
+}
+
+@end
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool {
+        NSArray<Person *> *people = @[
+            [[Person alloc] initWithName:@"Jane" age:34],
+            [[Person alloc] initWithName:@"John" age:29],
+        ];
+        // sort by age
+        NSArray *sorted = [people sortedArrayUsingComparator:^NSComparisonResult(Person *a, Person *b) {
+            return a.age < b.age ? NSOrderedAscending : NSOrderedDescending;
+        }];
+        for (Person *p in sorted)
+            NSLog(@"%@", [p greeting]);
+    }
+    return YES ? 0 : 1;
+}
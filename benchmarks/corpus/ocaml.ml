@@ -0,0 +1,36 @@
+(* A persistent binary search tree *)
+type 'a tree =
+  | Leaf
+  | Node of 'a tree * 'a * 'a tree
+
+let rec insert x = function
+  | Leaf -> Node (Leaf, x, Leaf)
+  | Node (l, v, r) as t ->
+    if x < v then Node (insert x l, v, r)
+    else if x > v then Node (l, v, insert x r)
+    else t
+
+let rec mem x = function
+  | Leaf -> false
+  | Node (l, v, r) -> x = v || (if x < v then mem x l else mem x r)
+
+let rec to_list = function
+  | Leaf -> []
+  | Node (l, v, r) -> to_list l @ (v :: to_list r)
+
+module StringMap = Map.Make (String)
+
+let count_words text =
+  String.split_on_char ' ' text
+  |> List.filter (fun w -> w <> "")
+  |> List.fold_left
+       (fun m w -> StringMap.update w (function None -> Some 1 | Some n -> Some (n + 1)) m)
+       StringMap.empty
+
+let () =
+  let t = List.fold_left (fun t x -> insert x t) Leaf [5; 3; 8; 1; 4] in
+  Printf.printf "%s\n" (String.concat ", " (List.map string_of_int (to_list t)));
+  Printf.printf "mem 4: %b, mem 7: %b\n" (mem 4 t) (mem 7 t);
+  StringMap.iter (fun w n -> Printf.printf "%s: %d\n" w n) (count_words "a b a c b a");
+  let pi = 4.0 *. atan 1.0 in
+  print_float pi; print_newline ()
@@ -0,0 +1,33 @@
+## -*- texinfo -*-
+## Fits a polynomial and prints its coefficients
+1;
+
+function p = fit_poly (x, y, degree)
+  if (nargin != 3)
+    print_usage ();
+  endif
+  p = polyfit (x, y, degree);
+endfunction
+
+x = linspace (0, 2*pi, 50);
+y = sin (x) + 0.1 * randn (size (x));
+
+for degree = 1:5
+  p = fit_poly (x, y, degree);
+  err = norm (polyval (p, x) - y);
+  printf ("degree %d: error %.4f\n", degree, err);
+  if (err < 0.8)
+    disp ("good enough");
+    break;
+  endif
+endfor
+
+# a cell array and a struct
+names = {"linear", "quadratic"};
+s.name = "fit";
+s.points = numel (x);
+unwind_protect
+  plot (x, y, "o", x, polyval (p, x), "-");
+unwind_protect_cleanup
+  close all;
+end_unwind_protect
@@ -0,0 +1,39 @@
+/* Element-wise operations on vectors */
+#define WORK_GROUP_SIZE 64
+
+__kernel void saxpy(const float a,
+                    __global const float *x,
+                    __global float *y,
+                    const uint n)
+{
+    size_t i = get_global_id(0);
+    if (i < n)
+        y[i] = a * x[i] + y[i];
+}
+
+__kernel void reduce_sum(__global const float4 *input,
+                         __global float *output,
+                         __local float *scratch)
+{
+    size_t gid = get_global_id(0);
+    size_t lid = get_local_id(0);
+    float4 v = input[gid];
+    scratch[lid] = v.x + v.y + v.z + v.w;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // tree reduction in local memory
+    for (size_t offset = get_local_size(0) / 2; offset > 0; offset >>= 1) {
+        if (lid < offset)
+            scratch[lid] += scratch[lid + offset];
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    if (lid == 0)
+        output[get_group_id(0)] = scratch[0];
+}
+
+__kernel void clamp_image(read_only image2d_t src, write_only image2d_t dst, sampler_t smp)
+{
+    int2 pos = (int2)(get_global_id(0), get_global_id(1));
+    float4 px = read_imagef(src, smp, pos);
+    write_imagef(dst, pos, clamp(px, 0.0f, 1.0f));
+}
@@ -0,0 +1,61 @@
+program Statistics;
+{ Computes basic statistics of a list of numbers }
+
+{$mode objfpc}{$H+}
+
+uses
+  SysUtils, Math;
+
+type
+  TNumbers = array of Double;
+
+function Mean(const Values: TNumbers): Double;
+var
+  I: Integer;
+  Total: Double;
+begin
+  Total := 0.0;
+  for I := Low(Values) to High(Values) do
+    Total := Total + Values[I];
+  if Length(Values) > 0 then
+    Result := Total / Length(Values)
+  else
+    Result := 0;
+end;
+
+procedure Sort(var Values: TNumbers);
+var
+  I, J: Integer;
+  Tmp: Double;
+begin
+  for I := 0 to High(Values) - 1 do
+    for J := I + 1 to High(Values) do
+      if Values[J] < Values[I] then
+      begin
+        Tmp := Values[I];
+        Values[I] := Values[J];
+        Values[J] := Tmp;
+      end;
+end;
+
+var
+  Data: TNumbers;
+  Line: string;
+begin
+  SetLength(Data, 0);
+  while not EOF do
+  begin
+    ReadLn(Line);
+    (* skip empty lines *)
+    if Trim(Line) = '' then Continue;
+    SetLength(Data, Length(Data) + 1);
+    Data[High(Data)] := StrToFloat(Line);
+  end;
+  Sort(Data);
+  WriteLn('Count: ', Length(Data));
+  WriteLn('Mean:  ', Mean(Data):0:3);
+  case Length(Data) mod 2 of
+    0: WriteLn('even');
+    1: WriteLn('odd');
+  end;
+end.
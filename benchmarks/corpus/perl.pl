@@ -0,0 +1,41 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+
+# Counts word frequencies of the files given on the command line
+my %count;
+my $total = 0;
+
+sub normalize {
+    my ($word) = @_;
+    $word =~ s/[^\w']//g;
+    return lc $word;
+}
+
+while (my $line = <>) {
+    chomp $line;
+    next if $line =~ /^\s*#/;
+    for my $word (split /\s+/, $line) {
+        $word = normalize($word);
+        next unless length $word;
+        $count{$word}++;
+        $total++;
+    }
+}
+
+my @sorted = sort { $count{$b} <=> $count{$a} || $a cmp $b } keys %count;
+printf "%-20s %6d\n", $_, $count{$_} for @sorted[0 .. ($#sorted < 9 ? $#sorted : 9)];
+print "Total: $total words, ", scalar(keys %count), " distinct\n";
+
+my $report = <<"END";
+Generated on @{[ scalar localtime ]}
+END
+print $report;
+
+__END__
+
+=head1 NAME
+
+wordcount - count word frequencies
+
+=cut
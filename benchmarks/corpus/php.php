@@ -0,0 +1,47 @@
+<!DOCTYPE html>
+<html>
+<head><title>Guest book</title></head>
+<body>
+<?php
+declare(strict_types=1);
+
+namespace App;
+
+/**
+ * A single entry of the guest book.
+ */
+final class Entry
+{
+    public function __construct(
+        private string $author,
+        private string $message,
+        private \DateTimeImmutable $date = new \DateTimeImmutable()
+    ) {
+    }
+
+    public function render(): string
+    {
+        $author = htmlspecialchars($this->author, ENT_QUOTES);
+        return sprintf('<li><b>%s</b>: %s <i>%s</i></li>', $author,
+                       htmlspecialchars($this->message), $this->date->format('Y-m-d'));
+    }
+}
+
+$entries = [];
+if ($_SERVER['REQUEST_METHOD'] === 'POST' && !empty($_POST['message'])) {
+    $entries[] = new Entry($_POST['author'] ?? 'anonymous', $_POST['message']);
+}
+
+// Render all entries
+echo "<ul>\n";
+foreach ($entries as $i => $entry) {
+    echo $entry->render(), "\n";
+}
+echo "</ul>\n";
+?>
+<form method="post">
+  <input name="author"> <textarea name="message"></textarea>
+  <button type="submit">Sign</button>
+</form>
+</body>
+</html>
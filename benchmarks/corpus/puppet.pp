@@ -0,0 +1,39 @@
+# Installs and configures the web server
+class webserver (
+  String  $package = 'nginx',
+  Integer $port    = 80,
+  Boolean $ssl     = false,
+) {
+  package { $package:
+    ensure => installed,
+  }
+
+  file { '/etc/nginx/conf.d/site.conf':
+    ensure  => file,
+    owner   => 'root',
+    mode    => '0644',
+    content => template('webserver/site.conf.erb'),
+    require => Package[$package],
+    notify  => Service['nginx'],
+  }
+
+  if $ssl {
+    include webserver::ssl
+  } elsif $port != 80 {
+    notice("Listening on non-standard port ${port}")
+  }
+
+  service { 'nginx':
+    ensure => running,
+    enable => true,
+  }
+
+  $users = ['alice', 'bob']
+  $users.each |$user| {
+    user { $user: ensure => present, shell => '/bin/bash' }
+  }
+}
+
+node 'web01.example.org' {
+  class { 'webserver': port => 8080 }
+}
@@ -0,0 +1,52 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""Counts the lines of code of a directory tree."""
+
+from __future__ import print_function
+
+import os
+import sys
+from collections import defaultdict
+
+EXTENSIONS = {'.py': 'Python', '.c': 'C', '.h': 'C', '.cpp': 'C++'}
+
+
+class Counter(object):
+    """Accumulates line counts per language."""
+
+    def __init__(self):
+        self.lines = defaultdict(int)
+        self.files = 0
+
+    def add(self, path):
+        ext = os.path.splitext(path)[1]
+        lang = EXTENSIONS.get(ext)
+        if lang is None:
+            return
+        with open(path) as f:
+            self.lines[lang] += sum(1 for line in f if line.strip())
+        self.files += 1
+
+    @property
+    def total(self):
+        return sum(self.lines.values())
+
+
+def main(argv):
+    root = argv[1] if len(argv) > 1 else '.'
+    counter = Counter()
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames[:] = [d for d in dirnames if not d.startswith('.')]
+        for name in filenames:
+            try:
+                counter.add(os.path.join(dirpath, name))
+            except (IOError, UnicodeDecodeError) as e:
+                print("skipping %s: %s" % (name, e), file=sys.stderr)
+    for lang, n in sorted(counter.lines.items(), key=lambda kv: -kv[1]):
+        print('{0:10} {1:8d}'.format(lang, n))
+    print(u'Total: %d lines in %d files' % (counter.total, counter.files))
+    return 0 if counter.files else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,61 @@
+import QtQuick 2.7
+import QtQuick.Controls 2.0
+import QtQuick.Layouts 1.3
+
+/*
+ * A simple to-do list
+ */
+ApplicationWindow {
+    id: window
+    width: 480
+    height: 640
+    visible: true
+    title: qsTr("To-do (%1)").arg(model.count)
+
+    property bool showDone: true
+    signal itemAdded(string text)
+
+    ListModel {
+        id: model
+        ListElement { text: "Buy milk"; done: false }
+        ListElement { text: "Write report"; done: true }
+    }
+
+    ColumnLayout {
+        anchors.fill: parent
+        anchors.margins: 8
+
+        RowLayout {
+            TextField {
+                id: input
+                Layout.fillWidth: true
+                placeholderText: "New item"
+                onAccepted: addButton.clicked()
+            }
+            Button {
+                id: addButton
+                text: "Add"
+                enabled: input.text.length > 0
+                onClicked: {
+                    model.append({ text: input.text, done: false })
+                    window.itemAdded(input.text)
+                    input.text = ""
+                }
+            }
+        }
+
+        ListView {
+            Layout.fillWidth: true
+            Layout.fillHeight: true
+            model: model
+            delegate: CheckBox {
+                text: model.text
+                checked: model.done
+                visible: window.showDone || !model.done
+                onToggled: model.done = checked
+            }
+        }
+    }
+
+    Component.onCompleted: console.log("loaded", model.count, "items")
+}
@@ -0,0 +1,55 @@
+%global commit 1a2b3c4
+%bcond_without tests
+
+Name:           example
+Version:        1.4.2
+Release:        1%{?dist}
+Summary:        An example library
+License:        LGPLv2+
+URL:            https://example.org/
+Source0:        %{url}/releases/%{name}-%{version}.tar.xz
+Patch0:         example-fix-build.patch
+
+BuildRequires:  gcc
+BuildRequires:  cmake >= 3.5
+BuildRequires:  pkgconfig(glib-2.0)
+Requires:       %{name}-libs%{?_isa} = %{version}-%{release}
+
+%description
+Example is a library used to demonstrate RPM spec files.
+
+%package devel
+Summary:        Development files for %{name}
+Requires:       %{name}%{?_isa} = %{version}-%{release}
+
+%description devel
+Header files and libraries of %{name}.
+
+%prep
+%autosetup -p1
+
+%build
+%cmake -DENABLE_DOCS=OFF .
+%make_build
+
+%install
+%make_install
+rm -f %{buildroot}%{_libdir}/*.la
+
+%check
+%if %{with tests}
+make test
+%endif
+
+%files
+%license COPYING
+%doc README.md
+%{_libdir}/lib%{name}.so.*
+
+%files devel
+%{_includedir}/%{name}/
+%{_libdir}/lib%{name}.so
+
+%changelog
+* Mon May 01 2017 Jane Doe <jane@example.org> - 1.4.2-1
+- Update to 1.4.2
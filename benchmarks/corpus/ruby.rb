@@ -0,0 +1,53 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+require 'json'
+require 'set'
+
+# An inventory of products
+module Shop
+  class Inventory
+    include Enumerable
+    attr_reader :items
+
+    def initialize(items = {})
+      @items = items
+      @@count ||= 0
+    end
+
+    def add(name, quantity: 1, price: 0.0)
+      raise ArgumentError, "quantity must be positive" unless quantity.positive?
+
+      item = (@items[name] ||= { quantity: 0, price: price })
+      item[:quantity] += quantity
+      self
+    end
+
+    def each(&block)
+      @items.each(&block)
+    end
+
+    def total
+      sum { |_, item| item[:quantity] * item[:price] }
+    end
+
+    def to_json(*args)
+      { items: @items, total: total }.to_json(*args)
+    end
+  end
+end
+
+inventory = Shop::Inventory.new
+inventory.add('apple', quantity: 3, price: 0.5)
+         .add(:pear, price: 0.75)
+puts "Total: #{format('%.2f', inventory.total)}"
+puts inventory.to_json
+tags = Set[*%w[fresh fruit local]]
+case tags.size
+when 0 then puts 'untagged'
+when 1..2 then puts 'few tags'
+else puts "#{tags.size} tags"
+end
+puts(/a+b/ =~ 'caab' ? 'match' : 'no match')
+__END__
+data that is not code
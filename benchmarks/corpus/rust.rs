@@ -0,0 +1,75 @@
+//! A tiny tokenizer for arithmetic expressions.
+
+use std::fmt;
+use std::iter::Peekable;
+use std::str::Chars;
+
+#[derive(Debug, Clone, PartialEq)]
+pub enum Token {
+    Number(f64),
+    Op(char),
+    LParen,
+    RParen,
+}
+
+impl fmt::Display for Token {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            Token::Number(n) => write!(f, "{}", n),
+            Token::Op(c) => write!(f, "{}", c),
+            Token::LParen => f.write_str("("),
+            Token::RParen => f.write_str(")"),
+        }
+    }
+}
+
+/// Iterates over the tokens of `input`.
+pub struct Lexer<'a> {
+    chars: Peekable<Chars<'a>>,
+}
+
+impl<'a> Lexer<'a> {
+    pub fn new(input: &'a str) -> Self {
+        Lexer { chars: input.chars().peekable() }
+    }
+
+    fn number(&mut self, first: char) -> Token {
+        let mut s = String::from(first);
+        while let Some(&c) = self.chars.peek() {
+            if c.is_ascii_digit() || c == '.' {
+                s.push(c);
+                self.chars.next();
+            } else {
+                break;
+            }
+        }
+        Token::Number(s.parse().unwrap_or(0.0))
+    }
+}
+
+impl<'a> Iterator for Lexer<'a> {
+    type Item = Token;
+
+    fn next(&mut self) -> Option<Token> {
+        loop {
+            let c = self.chars.next()?;
+            return Some(match c {
+                ' ' | '\t' => continue,
+                '0'..='9' => self.number(c),
+                '(' => Token::LParen,
+                ')' => Token::RParen,
+                '+' | '-' | '*' | '/' => Token::Op(c),
+                _ => panic!("unexpected character {:?}", c),
+            });
+        }
+    }
+}
+
+fn main() {
+    let tokens: Vec<Token> = Lexer::new("3.5 * (2 + 40) / 7").collect();
+    /* print the tokens separated by spaces */
+    let text = tokens.iter().map(|t| t.to_string()).collect::<Vec<_>>().join(" ");
+    println!("{} tokens: {}", tokens.len(), text);
+    let raw = r#"a "raw" string"#;
+    assert_eq!(raw.len(), 14);
+}
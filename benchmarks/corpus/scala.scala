@@ -0,0 +1,44 @@
+package example
+
+import scala.collection.mutable
+import scala.util.{Failure, Success, Try}
+
+/** A shape with an area. */
+sealed trait Shape {
+  def area: Double
+}
+
+case class Circle(radius: Double) extends Shape {
+  override def area: Double = math.Pi * radius * radius
+}
+
+case class Rect(width: Double, height: Double) extends Shape {
+  def area: Double = width * height
+}
+
+object Main extends App {
+  val shapes: List[Shape] = List(Circle(1.0), Rect(2, 3), Circle(0.5))
+
+  // describe every shape
+  shapes.foreach {
+    case Circle(r) if r < 1 => println(s"small circle of radius $r")
+    case c: Circle          => println(f"circle with area ${c.area}%.2f")
+    case Rect(w, h)         => println(s"rectangle ${w}x$h")
+  }
+
+  val total = shapes.map(_.area).sum
+  println(s"Total area: $total")
+
+  val counts = mutable.Map.empty[String, Int].withDefaultValue(0)
+  for (s <- shapes) counts(s.getClass.getSimpleName) += 1
+
+  Try("42".toInt) match {
+    case Success(n) => println(n + 1)
+    case Failure(e) => println(e.getMessage)
+  }
+
+  lazy val big = (1 to 1000000).view.filter(_ % 7 == 0).take(3).toList
+  println(big)
+  val multiline = """first line
+                    |second line""".stripMargin
+}
@@ -0,0 +1,36 @@
+;;; Utilities on lists and a small interpreter
+(define (fold f init lst)
+  (if (null? lst)
+      init
+      (fold f (f init (car lst)) (cdr lst))))
+
+(define (sum lst) (fold + 0 lst))
+
+(define (range a b)
+  (let loop ((i (- b 1)) (acc '()))
+    (if (< i a)
+        acc
+        (loop (- i 1) (cons i acc)))))
+
+(define (evaluate expr env)
+  (cond ((number? expr) expr)
+        ((symbol? expr) (cdr (assq expr env)))
+        ((eq? (car expr) 'add)
+         (+ (evaluate (cadr expr) env) (evaluate (caddr expr) env)))
+        ((eq? (car expr) 'mul)
+         (* (evaluate (cadr expr) env) (evaluate (caddr expr) env)))
+        (else (error "unknown expression" expr))))
+
+#| block
+   comment |#
+(define env '((x . 3) (y . 4)))
+(display (evaluate '(add x (mul y 10)) env))
+(newline)
+(display (sum (range 0 10)))
+(newline)
+(let* ((s "hello") (c #\a) (v #(1 2 3)))
+  (display (string-append s " " (string c)))
+  (display (vector-ref v 1)))
+(define-syntax swap!
+  (syntax-rules ()
+    ((_ a b) (let ((tmp a)) (set! a b) (set! b tmp)))))
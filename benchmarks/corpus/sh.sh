@@ -0,0 +1,42 @@
+#!/bin/sh
+# Creates compressed backups of the given directories.
+set -eu
+
+BACKUP_DIR="${BACKUP_DIR:-$HOME/backups}"
+KEEP=7
+DATE=$(date +%Y-%m-%d)
+
+usage() {
+    echo "Usage: $0 [-k keep] dir..." >&2
+    exit 1
+}
+
+while getopts "k:h" opt; do
+    case "$opt" in
+        k) KEEP="$OPTARG" ;;
+        h|*) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+[ $# -gt 0 ] || usage
+
+mkdir -p "$BACKUP_DIR"
+for dir in "$@"; do
+    if [ ! -d "$dir" ]; then
+        echo "warning: '$dir' is not a directory" >&2
+        continue
+    fi
+    name=$(basename "$dir")
+    archive="$BACKUP_DIR/$name-$DATE.tar.gz"
+    tar -czf "$archive" -C "$(dirname "$dir")" "$name"
+    echo "Created $archive ($(du -h "$archive" | cut -f1))"
+
+    # remove old backups
+    ls -1t "$BACKUP_DIR/$name"-*.tar.gz 2>/dev/null | tail -n +$((KEEP + 1)) | while read -r old; do
+        rm -f -- "$old"
+    done
+done
+
+cat <<EOF
+Backups are stored in $BACKUP_DIR
+EOF
@@ -0,0 +1,36 @@
+-- Schema and reports of a small shop
+CREATE TABLE customers (
+    id          INTEGER PRIMARY KEY,
+    name        VARCHAR(100) NOT NULL,
+    email       VARCHAR(255) UNIQUE,
+    created_at  TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+
+CREATE TABLE orders (
+    id          INTEGER PRIMARY KEY,
+    customer_id INTEGER NOT NULL REFERENCES customers (id) ON DELETE CASCADE,
+    total       DECIMAL(10, 2) CHECK (total >= 0),
+    status      CHAR(1) DEFAULT 'N'
+);
+
+CREATE INDEX orders_customer ON orders (customer_id);
+
+INSERT INTO customers (id, name, email) VALUES
+    (1, 'Jane Doe', 'jane@example.org'),
+    (2, 'John O''Brien', NULL);
+
+/* Best customers of the year */
+SELECT c.name,
+       COUNT(o.id) AS order_count,
+       SUM(o.total) AS revenue
+FROM customers c
+LEFT JOIN orders o ON o.customer_id = c.id
+WHERE o.status IN ('P', 'S')
+  AND c.created_at BETWEEN '2017-01-01' AND '2017-12-31'
+GROUP BY c.name
+HAVING SUM(o.total) > 100.0
+ORDER BY revenue DESC
+LIMIT 10;
+
+UPDATE orders SET status = 'C' WHERE total IS NULL OR total = 0;
+DELETE FROM customers WHERE NOT EXISTS (SELECT 1 FROM orders WHERE customer_id = customers.id);
@@ -0,0 +1,46 @@
+// A parameterized FIFO with an assertion
+module fifo #(
+    parameter int WIDTH = 8,
+    parameter int DEPTH = 16
+) (
+    input  logic             clk,
+    input  logic             rst_n,
+    input  logic             push,
+    input  logic             pop,
+    input  logic [WIDTH-1:0] din,
+    output logic [WIDTH-1:0] dout,
+    output logic             full,
+    output logic             empty
+);
+    localparam int AW = $clog2(DEPTH);
+
+    logic [WIDTH-1:0] mem [DEPTH];
+    logic [AW:0] wptr, rptr;
+
+    assign full  = (wptr[AW] != rptr[AW]) && (wptr[AW-1:0] == rptr[AW-1:0]);
+    assign empty = (wptr == rptr);
+    assign dout  = mem[rptr[AW-1:0]];
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            wptr <= '0;
+            rptr <= '0;
+        end else begin
+            if (push && !full) begin
+                mem[wptr[AW-1:0]] <= din;
+                wptr <= wptr + 1'b1;
+            end
+            if (pop && !empty)
+                rptr <= rptr + 1'b1;
+        end
+    end
+
+    /* never push into a full FIFO */
+    assert property (@(posedge clk) disable iff (!rst_n) !(push && full))
+        else $error("push while full");
+endmodule
+
+interface fifo_if (input logic clk);
+    logic push, pop;
+    modport producer (output push, input clk);
+endinterface
@@ -0,0 +1,46 @@
+#!/usr/bin/env tclsh
+# A simple key-value store with a command interface
+
+namespace eval store {
+    variable data [dict create]
+
+    proc set_value {key value} {
+        variable data
+        dict set data $key $value
+        return $value
+    }
+
+    proc get_value {key {default ""}} {
+        variable data
+        if {[dict exists $data $key]} {
+            return [dict get $data $key]
+        }
+        return $default
+    }
+
+    proc dump {} {
+        variable data
+        foreach key [lsort [dict keys $data]] {
+            puts [format "%-10s = %s" $key [dict get $data $key]]
+        }
+    }
+}
+
+store::set_value name "Liri Text"
+store::set_value version 1.0
+store::set_value count [expr {2 * 21}]
+
+set i 0
+while {$i < 3} {
+    incr i
+    switch -- $i {
+        1 { puts "one" }
+        2 { puts "two" }
+        default { puts "many: $i" }
+    }
+}
+
+if {[catch {open /nonexistent r} err]} {
+    puts stderr "error: $err"
+}
+store::dump
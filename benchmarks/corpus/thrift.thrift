@@ -0,0 +1,42 @@
+/*
+ * Interface of the calculator service
+ */
+namespace cpp example.calc
+namespace java org.example.calc
+namespace py calc
+
+include "shared.thrift"
+
+const i32 MAX_OPERANDS = 16
+const string VERSION = "1.0"
+
+typedef i64 Timestamp
+
+enum Operation {
+  ADD = 1,
+  SUBTRACT = 2,
+  MULTIPLY = 3,
+  DIVIDE = 4
+}
+
+struct Work {
+  1: required i32 num1 = 0,
+  2: required i32 num2,
+  3: Operation op,
+  4: optional string comment,
+  5: list<double> extra,
+  6: map<string, Timestamp> times
+}
+
+exception InvalidOperation {
+  1: i32 whatOp,
+  2: string why
+}
+
+// The service itself
+service Calculator extends shared.SharedService {
+  void ping(),
+  i32 add(1: i32 num1, 2: i32 num2),
+  i32 calculate(1: i32 logid, 2: Work w) throws (1: InvalidOperation ouch),
+  oneway void zip()
+}
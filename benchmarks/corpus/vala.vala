@@ -0,0 +1,43 @@
+/* A small GTK+ counter application */
+using Gtk;
+
+namespace Example {
+    public class CounterWindow : Gtk.ApplicationWindow {
+        private int count = 0;
+        private Label label;
+
+        public signal void changed (int value);
+
+        public CounterWindow (Gtk.Application app) {
+            Object (application: app, title: "Counter");
+            set_default_size (240, 120);
+
+            var box = new Box (Orientation.VERTICAL, 6);
+            label = new Label ("0");
+            var button = new Button.with_label ("Increment");
+            button.clicked.connect (() => {
+                count++;
+                label.label = @"$count";
+                changed (count);
+            });
+            box.pack_start (label, true, true, 0);
+            box.pack_start (button, false, false, 0);
+            add (box);
+        }
+
+        public int value {
+            get { return count; }
+        }
+    }
+
+    public static int main (string[] args) {
+        var app = new Gtk.Application ("org.example.Counter", ApplicationFlags.FLAGS_NONE);
+        app.activate.connect (() => {
+            var win = new CounterWindow (app);
+            win.changed.connect ((v) => stdout.printf ("value: %d\n", v));
+            win.show_all ();
+        });
+        // run the main loop
+        return app.run (args);
+    }
+}
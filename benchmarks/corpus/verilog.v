@@ -0,0 +1,46 @@
+// An 8-bit counter with synchronous load
+`timescale 1ns / 1ps
+`define WIDTH 8
+
+module counter (
+    input  wire              clk,
+    input  wire              reset,
+    input  wire              load,
+    input  wire [`WIDTH-1:0] data,
+    output reg  [`WIDTH-1:0] count,
+    output wire              overflow
+);
+    assign overflow = &count;
+
+    always @(posedge clk) begin
+        if (reset)
+            count <= 8'h00;
+        else if (load)
+            count <= data;
+        else
+            count <= count + 1'b1;
+    end
+endmodule
+
+/* Test bench */
+module counter_tb;
+    reg clk = 0, reset = 1, load = 0;
+    reg [7:0] data = 8'd200;
+    wire [7:0] count;
+    wire overflow;
+
+    counter dut (.clk(clk), .reset(reset), .load(load), .data(data),
+                 .count(count), .overflow(overflow));
+
+    always #5 clk = ~clk;
+
+    initial begin
+        $dumpfile("counter.vcd");
+        $dumpvars(0, counter_tb);
+        #12 reset = 0;
+        #20 load = 1;
+        #10 load = 0;
+        #600 $display("count = %d, overflow = %b", count, overflow);
+        $finish;
+    end
+endmodule
@@ -0,0 +1,41 @@
+-- A parameterized shift register
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity shift_register is
+    generic (
+        WIDTH : positive := 8
+    );
+    port (
+        clk    : in  std_logic;
+        reset  : in  std_logic;
+        enable : in  std_logic;
+        din    : in  std_logic;
+        dout   : out std_logic_vector(WIDTH - 1 downto 0)
+    );
+end entity shift_register;
+
+architecture rtl of shift_register is
+    signal reg : std_logic_vector(WIDTH - 1 downto 0) := (others => '0');
+    constant ZERO : unsigned(WIDTH - 1 downto 0) := to_unsigned(0, WIDTH);
+begin
+    process (clk)
+    begin
+        if rising_edge(clk) then
+            if reset = '1' then
+                reg <= (others => '0');
+            elsif enable = '1' then
+                reg <= reg(WIDTH - 2 downto 0) & din;
+            end if;
+        end if;
+    end process;
+
+    dout <= reg;
+
+    check : process (reg)
+    begin
+        assert unsigned(reg) /= ZERO or reset = '1'
+            report "register is empty" severity note;
+    end process check;
+end architecture rtl;
@@ -0,0 +1,40 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<!-- Renders the book catalog as an HTML table -->
+<xsl:stylesheet version="1.0"
+                xmlns:xsl="http://www.w3.org/1999/XSL/Transform"
+                xmlns:c="http://example.org/catalog"
+                exclude-result-prefixes="c">
+  <xsl:output method="html" indent="yes" encoding="UTF-8"/>
+  <xsl:param name="max-price" select="20"/>
+
+  <xsl:template match="/">
+    <html>
+      <body>
+        <h1>Catalog</h1>
+        <table border="1">
+          <tr><th>Title</th><th>Author</th><th>Price</th></tr>
+          <xsl:apply-templates select="c:catalog/c:book">
+            <xsl:sort select="c:price" data-type="number" order="descending"/>
+          </xsl:apply-templates>
+        </table>
+        <p>Total: <xsl:value-of select="format-number(sum(//c:price), '0.00')"/></p>
+      </body>
+    </html>
+  </xsl:template>
+
+  <xsl:template match="c:book">
+    <tr>
+      <xsl:if test="c:price &gt; $max-price">
+        <xsl:attribute name="class">expensive</xsl:attribute>
+      </xsl:if>
+      <td><xsl:value-of select="c:title"/></td>
+      <td><xsl:value-of select="c:author"/></td>
+      <td>
+        <xsl:choose>
+          <xsl:when test="@available = 'true'"><xsl:value-of select="c:price"/></xsl:when>
+          <xsl:otherwise>n/a</xsl:otherwise>
+        </xsl:choose>
+      </td>
+    </tr>
+  </xsl:template>
+</xsl:stylesheet>
@@ -0,0 +1,60 @@
+%{
+/* A calculator grammar */
+#include <stdio.h>
+#include <stdlib.h>
+
+int yylex(void);
+void yyerror(const char *s);
+%}
+
+%union {
+    double value;
+    char *name;
+}
+
+%token <value> NUMBER
+%token <name> IDENTIFIER
+%token PRINT
+%type <value> expr
+%left '+' '-'
+%left '*' '/'
+%right UMINUS
+
+%%
+
+input
+    : /* empty */
+    | input line
+    ;
+
+line
+    : '\n'
+    | PRINT expr '\n'   { printf("%g\n", $2); }
+    | error '\n'        { yyerrok; }
+    ;
+
+expr
+    : NUMBER                { $$ = $1; }
+    | expr '+' expr         { $$ = $1 + $3; }
+    | expr '-' expr         { $$ = $1 - $3; }
+    | expr '*' expr         { $$ = $1 * $3; }
+    | expr '/' expr         {
+                              if ($3 == 0.0)
+                                  yyerror("division by zero");
+                              $$ = $1 / $3;
+                            }
+    | '-' expr %prec UMINUS { $$ = -$2; }
+    | '(' expr ')'          { $$ = $2; }
+    ;
+
+%%
+
+void yyerror(const char *s)
+{
+    fprintf(stderr, "error: %s\n", s);
+}
+
+int main(void)
+{
+    return yyparse();
+}
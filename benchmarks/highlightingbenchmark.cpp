@@ -0,0 +1,366 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QGuiApplication>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "highlightengine.h"
+#include "highlightstatetable.h"
+#include "languagecache.h"
+#include "languageloader.h"
+#include "languagemanager.h"
+#include "lirisyntaxhighlighter.h"
+
+// Samples are repeated up to this many lines, so that lexing outweighs the thread handoffs
+static const int SampleLines = 5000;
+
+/* Highlights a sample of every bundled language with LiriSyntaxHighlighter,
+ * the same way the editor does, and with HighlightEngine alone to tell lexing
+ * apart from the rest. The figures are written to a JSON file.
+ * Samples are taken from BENCHMARK_CORPUS_PATH or $LIRI_TEXT_BENCH_CORPUS,
+ * named after the spec file with any extension. A language without a sample
+ * fails, hidden ones are only included by others and are left out.
+ * The report goes to $LIRI_TEXT_BENCH_JSON, liri-text-bench.json by default.
+ * Peak memory is that of the whole process, the growth of the peak during
+ * a run is reported along with it.
+ */
+class HighlightingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void lexing_data();
+    void lexing();
+    void fullRehighlight_data();
+    void fullRehighlight();
+    void incrementalRehighlight_data();
+    void incrementalRehighlight();
+    void cleanupTestCase();
+
+private:
+    void addSpecs();
+    QString samplePath(const QString &id) const;
+    QString loadSample(const QString &id) const;
+    void record(const QString &id, const QString &kind, const QString &text, int iterations,
+                qint64 nsecs);
+    static bool waitForHighlighting(const QTextDocument &document);
+    static qint64 peakMemoryKiB();
+
+    QSharedPointer<LanguageDefaultStyles> m_defStyles;
+    QDir m_corpus;
+    QJsonObject m_results;
+    qint64 m_peakMemoryBefore = -1;
+};
+
+void HighlightingBenchmark::initTestCase()
+{
+    m_defStyles = QSharedPointer<LanguageDefaultStyles>::create();
+    const QString corpus = qEnvironmentVariable("LIRI_TEXT_BENCH_CORPUS");
+    m_corpus = QDir(corpus.isEmpty() ? QStringLiteral(BENCHMARK_CORPUS_PATH) : corpus);
+
+    // Specs refer to each other by id, which needs the language database
+    QTRY_VERIFY_WITH_TIMEOUT(
+        !LanguageManager::getInstance()->pathForId(QStringLiteral("def")).isEmpty(), 60000);
+}
+
+void HighlightingBenchmark::init()
+{
+    m_peakMemoryBefore = peakMemoryKiB();
+}
+
+void HighlightingBenchmark::addSpecs()
+{
+    QTest::addColumn<QString>("specPath");
+
+    const QDir specs(QStringLiteral(SOURCE_LANGUAGE_PATH));
+    const QFileInfoList files =
+        specs.entryInfoList({ QStringLiteral("*.lang") }, QDir::Files, QDir::Name);
+    LanguageLoader loader;
+    for (const QFileInfo &file : files) {
+        const LanguageMetadata metadata = loader.loadMetadata(file.filePath());
+        if (!metadata.id.isEmpty() && !metadata.hidden)
+            QTest::newRow(qPrintable(file.completeBaseName())) << file.filePath();
+    }
+}
+
+QString HighlightingBenchmark::samplePath(const QString &id) const
+{
+    const QFileInfoList samples =
+        m_corpus.entryInfoList({ id + QStringLiteral(".*"), id }, QDir::Files, QDir::Name);
+    for (const QFileInfo &sample : samples) {
+        if (sample.completeBaseName() == id || sample.fileName() == id)
+            return sample.filePath();
+    }
+    return QString();
+}
+
+QString HighlightingBenchmark::loadSample(const QString &id) const
+{
+    QFile sample(samplePath(id));
+    if (!sample.open(QFile::ReadOnly | QFile::Text))
+        return QString();
+    QString text = QString::fromUtf8(sample.readAll());
+    if (text.isEmpty())
+        return text;
+    if (!text.endsWith(QLatin1Char('\n')))
+        text += QLatin1Char('\n');
+
+    const int lines = text.count(QLatin1Char('\n'));
+    QString repeated;
+    repeated.reserve(text.size() * ((SampleLines + lines - 1) / lines));
+    for (int i = 0; i < SampleLines; i += lines)
+        repeated += text;
+    repeated.chop(1);
+    return repeated;
+}
+
+void HighlightingBenchmark::lexing_data()
+{
+    addSpecs();
+}
+
+void HighlightingBenchmark::lexing()
+{
+    QFETCH(QString, specPath);
+    const QString id = QFileInfo(specPath).completeBaseName();
+    const QString text = loadSample(id);
+    QVERIFY2(!text.isEmpty(), "No corpus sample for this language");
+
+    auto language = LanguageCache::getInstance()->languageForPath(specPath);
+    QVERIFY(language);
+    QVector<QTextCharFormat> formats;
+    formats.reserve(language->styles.size());
+    for (const QString &style : qAsConst(language->styles))
+        formats.append(m_defStyles->styles.value(style));
+
+    const QStringList lines = text.split(QLatin1Char('\n'));
+    int iterations = 0;
+    qint64 nsecs = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        timer.start();
+        // A new state table each round, as after loading a document
+        auto states = QSharedPointer<HighlightStateTable>::create();
+        states->reset(language->program->context(0).styleIndex);
+        HighlightEngine engine(language->program, formats, states);
+        int state = -1;
+        for (int i = 0; i < lines.size(); ++i)
+            state = engine.highlightLine(lines.at(i), state, i == 0).state;
+        nsecs += timer.nsecsElapsed();
+        ++iterations;
+    }
+    record(id, QStringLiteral("lex"), text, iterations, nsecs);
+}
+
+void HighlightingBenchmark::fullRehighlight_data()
+{
+    addSpecs();
+}
+
+void HighlightingBenchmark::fullRehighlight()
+{
+    QFETCH(QString, specPath);
+    const QString id = QFileInfo(specPath).completeBaseName();
+    const QString text = loadSample(id);
+    QVERIFY2(!text.isEmpty(), "No corpus sample for this language");
+
+    auto language = LanguageCache::getInstance()->languageForPath(specPath);
+    QVERIFY(language);
+
+    QTextDocument document(text);
+    LiriSyntaxHighlighter highlighter(&document);
+    highlighter.setDefaultStyles(m_defStyles);
+    highlighter.setLanguage(language);
+    QVERIFY(waitForHighlighting(document));
+
+    int iterations = 0;
+    qint64 nsecs = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        timer.start();
+        // Setting the styles again highlights the whole document anew
+        highlighter.setDefaultStyles(m_defStyles);
+        QVERIFY(waitForHighlighting(document));
+        nsecs += timer.nsecsElapsed();
+        ++iterations;
+    }
+    record(id, QStringLiteral("full"), text, iterations, nsecs);
+}
+
+void HighlightingBenchmark::incrementalRehighlight_data()
+{
+    addSpecs();
+}
+
+void HighlightingBenchmark::incrementalRehighlight()
+{
+    QFETCH(QString, specPath);
+    const QString id = QFileInfo(specPath).completeBaseName();
+    const QString text = loadSample(id);
+    QVERIFY2(!text.isEmpty(), "No corpus sample for this language");
+
+    auto language = LanguageCache::getInstance()->languageForPath(specPath);
+    QVERIFY(language);
+
+    QTextDocument document(text);
+    LiriSyntaxHighlighter highlighter(&document);
+    highlighter.setDefaultStyles(m_defStyles);
+    highlighter.setLanguage(language);
+    QVERIFY(waitForHighlighting(document));
+
+    // Typing in the middle of the file, the edit is undone in the next round
+    QTextCursor cursor(document.findBlockByNumber(document.blockCount() / 2));
+    bool inserted = false;
+    int iterations = 0;
+    qint64 nsecs = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        timer.start();
+        if (inserted) {
+            cursor.deletePreviousChar();
+        } else {
+            cursor.insertText(QStringLiteral("x"));
+        }
+        inserted = !inserted;
+        QVERIFY(waitForHighlighting(document));
+        nsecs += timer.nsecsElapsed();
+        ++iterations;
+    }
+    record(id, QStringLiteral("incremental"), text, iterations, nsecs);
+}
+
+void HighlightingBenchmark::cleanupTestCase()
+{
+    QString path = qEnvironmentVariable("LIRI_TEXT_BENCH_JSON");
+    if (path.isEmpty())
+        path = QStringLiteral("liri-text-bench.json");
+
+    QJsonObject report;
+    report.insert(QStringLiteral("qtVersion"), QString::fromLatin1(qVersion()));
+    report.insert(QStringLiteral("languages"), m_results);
+    QFile file(path);
+    QVERIFY2(file.open(QFile::WriteOnly | QFile::Truncate), qPrintable(file.errorString()));
+    file.write(QJsonDocument(report).toJson());
+}
+
+void HighlightingBenchmark::record(const QString &id, const QString &kind, const QString &text,
+                                   int iterations, qint64 nsecs)
+{
+    if (iterations == 0)
+        return;
+
+    const double seconds = nsecs / 1e9 / iterations;
+    const int lines = text.count(QLatin1Char('\n')) + 1;
+    const int bytes = text.toUtf8().size();
+
+    QJsonObject run;
+    run.insert(QStringLiteral("iterations"), iterations);
+    run.insert(QStringLiteral("msecs"), seconds * 1000);
+    // Incremental runs highlight what one keystroke invalidates, not the whole file
+    if (kind != QLatin1String("incremental")) {
+        run.insert(QStringLiteral("linesPerSecond"), seconds > 0 ? lines / seconds : 0);
+        run.insert(QStringLiteral("bytesPerSecond"), seconds > 0 ? bytes / seconds : 0);
+    }
+    // The peak of the whole process so far, so it never goes down between languages
+    const qint64 peakMemory = peakMemoryKiB();
+    run.insert(QStringLiteral("peakMemoryKiB"), peakMemory);
+    // How much this run raised the peak, zero if it stayed below an earlier one
+    if (peakMemory >= 0 && m_peakMemoryBefore >= 0)
+        run.insert(QStringLiteral("peakMemoryGrowthKiB"), peakMemory - m_peakMemoryBefore);
+
+    QJsonObject language = m_results.value(id).toObject();
+    language.insert(QStringLiteral("lines"), lines);
+    language.insert(QStringLiteral("bytes"), bytes);
+    language.insert(kind, run);
+    m_results.insert(id, language);
+}
+
+bool HighlightingBenchmark::waitForHighlighting(const QTextDocument &document)
+{
+    /* The worker and the time-sliced cascade leave negative states
+     * on the blocks they haven't got to yet
+     */
+    QElapsedTimer timeout;
+    timeout.start();
+    for (;;) {
+        QTextBlock block = document.begin();
+        while (block.isValid()) {
+            if (block.userState() >= 0) {
+                block = block.next();
+                continue;
+            }
+            if (timeout.elapsed() > 60000)
+                return false;
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+        // Earlier blocks may have been reset by a restarted worker meanwhile
+        bool done = true;
+        for (block = document.begin(); block.isValid() && done; block = block.next())
+            done = block.userState() >= 0;
+        if (done)
+            return true;
+    }
+}
+
+qint64 HighlightingBenchmark::peakMemoryKiB()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#ifdef Q_OS_DARWIN
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    // Nothing is shown, so don't depend on a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("liri-text-bench"));
+    // Keep the language database of the benchmark apart from the user's
+    QStandardPaths::setTestModeEnabled(true);
+    LanguageManager::setSpecsDirectories({ QStringLiteral(SOURCE_LANGUAGE_PATH) });
+
+    HighlightingBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "highlightingbenchmark.moc"
@@ -0,0 +1,359 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "containermatcher.h"
+#include <QDebug>
+
+ContainerMatcher::ContainerMatcher(const ContextProgram &program, int container)
+    : m_order(0)
+{
+    addIncludes(program, container);
+    addOnceOnly(program, container);
+    compile(m_unbounded);
+    compile(m_bounded);
+}
+
+ContainerMatcher::Result ContainerMatcher::match(const QString &text, int offset,
+                                                 int potentialEnd, Cache *cache) const
+{
+    if (cache && cache->entries.size() != 2 + m_wordTables.size())
+        cache->entries.resize(2 + m_wordTables.size());
+
+    const QStringRef unboundedSubject(&text);
+    Result best;
+    if (!lookup(cache, 0, unboundedSubject, offset, &best)) {
+        best = matchAlternation(m_unbounded, unboundedSubject, offset);
+        store(cache, 0, unboundedSubject, offset, best);
+    }
+
+    const QStringRef boundedSubject = QStringRef(&text).left(potentialEnd);
+    Result bounded;
+    if (!lookup(cache, 1, boundedSubject, offset, &bounded)) {
+        bounded = matchAlternation(m_bounded, boundedSubject, offset);
+        store(cache, 1, boundedSubject, offset, bounded);
+    }
+    // A scan over the limits leaves the result unknown
+    if (!best.match.isValid())
+        return best;
+    if (!bounded.match.isValid())
+        return bounded;
+    if (precedes(bounded, best))
+        best = bounded;
+
+    for (int i = 0; i < m_wordTables.size(); ++i) {
+        const WordTable &table = m_wordTables.at(i);
+        const QStringRef subject = table.extendParent ? unboundedSubject : boundedSubject;
+        Result word;
+        if (!lookup(cache, 2 + i, subject, offset, &word)) {
+            word = matchWords(table, subject, offset);
+            store(cache, 2 + i, subject, offset, word);
+        }
+        if (!word.match.isValid())
+            return word;
+        if (precedes(word, best))
+            best = word;
+    }
+    return best;
+}
+
+int ContainerMatcher::optimize() const
+{
+    int regexes = 0;
+    for (const Alternation *alternation : { &m_unbounded, &m_bounded }) {
+        if (alternation->branches.isEmpty())
+            continue;
+        alternation->regex.optimize();
+        ++regexes;
+    }
+    for (const WordTable &table : m_wordTables) {
+        table.regex.optimize();
+        ++regexes;
+    }
+    return regexes;
+}
+
+void ContainerMatcher::addIncludes(const ContextProgram &program, int container)
+{
+    const ContextProgram::Context &parent = program.context(container);
+    for (int i = 0; i < parent.childCount; ++i) {
+        const int inc = program.child(parent, i);
+        const ContextProgram::Context &context = program.context(inc);
+        switch (context.type) {
+        case LanguageContext::Keyword: {
+            const LanguageContextKeyword *keyword = context.keyword;
+            bool combinable =
+                !context.is(ContextProgram::FirstLineOnly) && !context.is(ContextProgram::OnceOnly);
+            for (const QRegularExpression &kw : qAsConst(keyword->keywords))
+                combinable = combinable && isCombinable(kw);
+
+            if (combinable) {
+                for (int j = 0; j < keyword->keywords.size(); ++j)
+                    addBranch(keyword->keywords.at(j), context.is(ContextProgram::ExtendParent),
+                              inc, m_order + keyword->keywordPositions.at(j));
+                addWords(keyword, context.is(ContextProgram::ExtendParent), inc);
+            } else {
+                addFallback(inc);
+            }
+            // Every keyword of the context has its own place in the matching order
+            m_order += qMax(keyword->keywordCount(), 1);
+            break;
+        }
+        case LanguageContext::Simple: {
+            if (!context.is(ContextProgram::FirstLineOnly) && !context.is(ContextProgram::OnceOnly)
+                && isCombinable(context.regex))
+                addBranch(context.regex, context.is(ContextProgram::ExtendParent), inc, m_order);
+            else
+                addFallback(inc);
+            ++m_order;
+            break;
+        }
+        case LanguageContext::Container: {
+            if (context.is(ContextProgram::FirstLineOnly) || context.is(ContextProgram::OnceOnly)) {
+                addFallback(inc);
+                ++m_order;
+            } else if (context.is(ContextProgram::IncludesOnly)) {
+                // Every nested include keeps its own place in the matching order
+                addIncludes(program, inc);
+            } else {
+                if (isCombinable(context.regex))
+                    addBranch(context.regex, context.is(ContextProgram::ExtendParent), inc,
+                              m_order);
+                else
+                    addFallback(inc);
+                ++m_order;
+            }
+            break;
+        }
+        default: {
+            // Sub-patterns never match on their own
+            break;
+        }
+        }
+    }
+}
+
+void ContainerMatcher::addBranch(const QRegularExpression &regex, bool extendParent, int context,
+                                 int order)
+{
+    Alternation &alternation = extendParent ? m_unbounded : m_bounded;
+    const bool caseInsensitive =
+        (regex.patternOptions() & QRegularExpression::CaseInsensitiveOption) != 0;
+    const bool extended =
+        (regex.patternOptions() & QRegularExpression::ExtendedPatternSyntaxOption) != 0;
+
+    // Scope the options of the original regex to its own branch
+    QString options;
+    if (caseInsensitive)
+        options += 'i';
+    if (extended)
+        options += 'x';
+    if (!caseInsensitive || !extended) {
+        options += '-';
+        if (!caseInsensitive)
+            options += 'i';
+        if (!extended)
+            options += 'x';
+    }
+
+    if (!alternation.branches.isEmpty())
+        alternation.pattern += '|';
+    alternation.pattern += QLatin1String("((?");
+    alternation.pattern += options;
+    alternation.pattern += ':';
+    alternation.pattern += ContextProgram::unlimitPattern(regex.pattern());
+    // A trailing comment in extended syntax would swallow the closing brackets
+    if (extended)
+        alternation.pattern += '\n';
+    alternation.pattern += QLatin1String("))");
+
+    alternation.branches.append({ regex, context, order, alternation.captureCount + 1 });
+    alternation.captureCount += 1 + regex.captureCount();
+}
+
+void ContainerMatcher::addWords(const LanguageContextKeyword *keyword, bool extendParent,
+                                int context)
+{
+    if (keyword->words.isEmpty() && keyword->caseInsensitiveWords.isEmpty())
+        return;
+
+    // Keyword contexts sharing the word regex are looked up with a single scan
+    WordTable *table = nullptr;
+    for (WordTable &candidate : m_wordTables) {
+        if (candidate.regex == keyword->wordRegex && candidate.extendParent == extendParent) {
+            table = &candidate;
+            break;
+        }
+    }
+    if (!table) {
+        m_wordTables.append(WordTable());
+        table = &m_wordTables.last();
+        table->regex = keyword->wordRegex;
+        table->extendParent = extendParent;
+    }
+
+    // Earlier includes win for duplicate words
+    for (auto it = keyword->words.constBegin(), end = keyword->words.constEnd(); it != end; ++it) {
+        if (!table->words.contains(it.key()))
+            table->words.insert(it.key(), { context, m_order + it.value() });
+    }
+    for (auto it = keyword->caseInsensitiveWords.constBegin(),
+              end = keyword->caseInsensitiveWords.constEnd();
+         it != end; ++it) {
+        if (!table->caseInsensitiveWords.contains(it.key()))
+            table->caseInsensitiveWords.insert(it.key(), { context, m_order + it.value() });
+    }
+}
+
+void ContainerMatcher::addFallback(int context)
+{
+    m_fallbacks.append({ context, m_order });
+}
+
+void ContainerMatcher::addOnceOnly(const ContextProgram &program, int container)
+{
+    const ContextProgram::Context &parent = program.context(container);
+    for (int i = 0; i < parent.childCount; ++i) {
+        const int inc = program.child(parent, i);
+        const ContextProgram::Context &context = program.context(inc);
+        if (context.type == LanguageContext::SubPattern)
+            continue;
+
+        // Only the nested includes are ever reported as matches
+        if (context.type == LanguageContext::Container && context.is(ContextProgram::IncludesOnly))
+            addOnceOnly(program, inc);
+        else if (context.is(ContextProgram::OnceOnly) && !m_onceOnlyBits.contains(inc))
+            m_onceOnlyBits.insert(inc, m_onceOnlyBits.size());
+    }
+}
+
+void ContainerMatcher::compile(Alternation &alternation)
+{
+    if (alternation.branches.isEmpty())
+        return;
+
+    // Different contexts are free to use the same group names
+    alternation.regex.setPattern(
+        ContextProgram::limitPattern(QLatin1String("(?J)") + alternation.pattern));
+    if (alternation.regex.isValid())
+        return;
+
+    qDebug() << "Can't combine container includes:" << alternation.regex.errorString();
+    for (const Branch &branch : qAsConst(alternation.branches)) {
+        if (m_fallbacks.isEmpty() || m_fallbacks.constLast().context != branch.context)
+            m_fallbacks.append({ branch.context, branch.order });
+    }
+    alternation.branches.clear();
+}
+
+ContainerMatcher::Result ContainerMatcher::matchAlternation(const Alternation &alternation,
+                                                            const QStringRef &subject,
+                                                            int offset) const
+{
+    if (alternation.branches.isEmpty())
+        return Result();
+
+    QRegularExpressionMatch combined = alternation.regex.match(subject, offset);
+    // Over the limits, the invalid match is passed on
+    if (!combined.isValid())
+        return { combined, -1, 0 };
+    if (!combined.hasMatch())
+        return Result();
+
+    for (const Branch &branch : alternation.branches) {
+        if (combined.capturedStart(branch.marker) < 0)
+            continue;
+
+        // Run the winning branch alone, so capture groups keep their original numbers
+        QRegularExpressionMatch match =
+            branch.regex.match(subject, combined.capturedStart(), QRegularExpression::NormalMatch,
+                               QRegularExpression::AnchoredMatchOption);
+        if (!match.hasMatch())
+            match = branch.regex.match(subject, offset);
+        return { match, branch.context, branch.order };
+    }
+    return Result();
+}
+
+ContainerMatcher::Result ContainerMatcher::matchWords(const WordTable &table,
+                                                      const QStringRef &subject,
+                                                      int offset) const
+{
+    const Fallback *found = nullptr;
+    QRegularExpressionMatch match = LanguageContextKeyword::findWord(
+            table.regex, table.words, table.caseInsensitiveWords, subject, offset,
+            [](const Fallback &word) { return word.order; }, &found);
+    if (!found)
+        return { match, -1, 0 };
+    return { match, found->context, found->order };
+}
+
+bool ContainerMatcher::lookup(const Cache *cache, int index, const QStringRef &subject,
+                              int offset, Result *result)
+{
+    if (!cache)
+        return false;
+
+    const Cache::Entry &entry = cache->entries.at(index);
+    // The subject differs when the end of the container has moved
+    if (entry.offset < 0 || entry.offset > offset || entry.length != subject.length())
+        return false;
+    if (entry.result.match.hasMatch() && entry.result.match.capturedStart() < offset)
+        return false;
+
+    *result = entry.result;
+    return true;
+}
+
+void ContainerMatcher::store(Cache *cache, int index, const QStringRef &subject, int offset,
+                             const Result &result)
+{
+    if (!cache)
+        return;
+
+    Cache::Entry &entry = cache->entries[index];
+    entry.result = result;
+    entry.offset = offset;
+    entry.length = subject.length();
+}
+
+bool ContainerMatcher::isCombinable(const QRegularExpression &regex)
+{
+    const QRegularExpression::PatternOptions supportedOptions =
+        QRegularExpression::CaseInsensitiveOption | QRegularExpression::ExtendedPatternSyntaxOption
+        | QRegularExpression::OptimizeOnFirstUsageOption
+        | QRegularExpression::DontAutomaticallyOptimizeOption;
+    if (!regex.isValid() || (regex.patternOptions() & ~supportedOptions) != 0)
+        return false;
+
+    // Group references, recursion and leading verbs change meaning inside an alternation
+    static const QRegularExpression unsafeConstructs(QStringLiteral(
+        "\\\\(?:[1-9gkK]|[0-9]{2})|\\(\\?(?:P[=>]|[0-9R&(]|[+-][0-9])|\\(\\*"));
+    return !unsafeConstructs.match(ContextProgram::unlimitPattern(regex.pattern())).hasMatch();
+}
+
+bool ContainerMatcher::precedes(const Result &result, const Result &other)
+{
+    if (!result.match.hasMatch())
+        return false;
+    if (!other.match.hasMatch())
+        return true;
+    if (result.match.capturedStart() == other.match.capturedStart())
+        return result.order < other.order;
+    return result.match.capturedStart() < other.match.capturedStart();
+}
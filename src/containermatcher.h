@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONTAINERMATCHER_H
+#define CONTAINERMATCHER_H
+
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QRegularExpression>
+#include <QRegularExpressionMatch>
+#include "contextprogram.h"
+
+/* Matches all includes of a container in a single regex scan.
+ * Every includable pattern becomes a branch of one alternation, wrapped into
+ * a capturing group that tells which branch won. Plain keywords of all keyword
+ * contexts are merged into word tables instead. Contexts which can't be
+ * expressed this way (once-only, first-line-only, back-references etc.)
+ * are left for the caller to match one by one.
+ */
+class ContainerMatcher
+{
+    Q_DISABLE_COPY(ContainerMatcher)
+public:
+    struct Result
+    {
+        QRegularExpressionMatch match;
+        int context;
+        int order;
+    };
+
+    struct Fallback
+    {
+        int context;
+        int order;
+    };
+
+    /* Results of earlier scans over the same line. A result stays valid until
+     * the offset moves past its start, because no match can begin in between.
+     */
+    struct Cache
+    {
+        struct Entry
+        {
+            Result result;
+            int offset = -1;
+            int length = -1;
+        };
+
+        QVector<Entry> entries;
+    };
+
+    ContainerMatcher(const ContextProgram &program, int container);
+
+    Result match(const QString &text, int offset, int potentialEnd, Cache *cache = nullptr) const;
+    // Compiles the combined regexes ahead of use, returns how many there are
+    int optimize() const;
+    inline const QList<Fallback> &fallbacks() const { return m_fallbacks; }
+    // Once-only includes are numbered to keep what has matched in a bitset
+    inline int onceOnlyCount() const { return m_onceOnlyBits.size(); }
+    inline int onceOnlyBit(int context) const
+    {
+        return m_onceOnlyBits.value(context, -1);
+    }
+
+private:
+    struct Branch
+    {
+        QRegularExpression regex;
+        int context;
+        int order;
+        int marker;
+    };
+
+    struct Alternation
+    {
+        QString pattern;
+        QRegularExpression regex;
+        QVector<Branch> branches;
+        int captureCount = 0;
+    };
+
+    struct WordTable
+    {
+        QRegularExpression regex;
+        bool extendParent;
+        QHash<QString, Fallback> words;
+        QHash<QString, Fallback> caseInsensitiveWords;
+    };
+
+    void addIncludes(const ContextProgram &program, int container);
+    void addBranch(const QRegularExpression &regex, bool extendParent, int context, int order);
+    void addWords(const LanguageContextKeyword *keyword, bool extendParent, int context);
+    void addFallback(int context);
+    void addOnceOnly(const ContextProgram &program, int container);
+    void compile(Alternation &alternation);
+    Result matchAlternation(const Alternation &alternation, const QStringRef &subject,
+                            int offset) const;
+    Result matchWords(const WordTable &table, const QStringRef &subject, int offset) const;
+    static bool lookup(const Cache *cache, int index, const QStringRef &subject, int offset,
+                       Result *result);
+    static void store(Cache *cache, int index, const QStringRef &subject, int offset,
+                      const Result &result);
+    static bool isCombinable(const QRegularExpression &regex);
+    static bool precedes(const Result &result, const Result &other);
+
+    // Contexts with extend-parent="false" can't match past the container end
+    Alternation m_unbounded;
+    Alternation m_bounded;
+    QVector<WordTable> m_wordTables;
+    QList<Fallback> m_fallbacks;
+    QHash<int, int> m_onceOnlyBits;
+    int m_order;
+};
+
+#endif // CONTAINERMATCHER_H
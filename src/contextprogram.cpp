@@ -0,0 +1,415 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "contextprogram.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QSemaphore>
+#include <QThreadPool>
+#include "containermatcher.h"
+#include "functionrunnable.h"
+#include "languagecontextcontainer.h"
+#include "languagecontextsimple.h"
+#include "languagecontextsubpattern.h"
+
+// Warm-up times, enabled with QT_LOGGING_RULES="liri.text.contextprogram.debug=true"
+Q_LOGGING_CATEGORY(lcContextProgram, "liri.text.contextprogram", QtInfoMsg)
+
+// Backtracking steps one match may take, a tenth of PCRE2's default
+static const int MatchLimit = 1000000;
+// Enough for a group repeated once per character of the longest line highlighted
+static const int DepthLimit = 50000;
+
+namespace {
+
+const QString &limitPrefix()
+{
+    // Before PCRE2 10.30 the depth limit was called the recursion limit
+    static const QString prefix =
+        QStringLiteral("(*LIMIT_MATCH=%1)(*%2=%3)")
+            .arg(MatchLimit)
+            .arg(QRegularExpression(QStringLiteral("(*LIMIT_DEPTH=1)")).isValid()
+                     ? QStringLiteral("LIMIT_DEPTH")
+                     : QStringLiteral("LIMIT_RECURSION"))
+            .arg(DepthLimit);
+    return prefix;
+}
+
+} // namespace
+
+ContextProgram::ContextProgram(const QSharedPointer<LanguageContext> &mainContext)
+{
+    indexOf(mainContext, QStringLiteral("main"));
+    // Contexts are numbered as they are reached, compile() may queue more of them
+    for (int i = 0; i < m_queue.size(); ++i) {
+        const QSharedPointer<LanguageContext> context = m_queue.at(i);
+        compile(context);
+    }
+
+    m_nodeCount = m_indices.size();
+    m_indices.clear();
+    m_shared.clear();
+    m_queue.clear();
+    m_limited.clear();
+    m_contexts.squeeze();
+    m_children.squeeze();
+    allocateMatchers();
+    if (RegexProfile::isEnabled())
+        m_profile = QSharedPointer<RegexProfile>::create(m_names);
+}
+
+ContextProgram::~ContextProgram()
+{
+    // Programs which failed to load have none
+    if (!m_matchers)
+        return;
+    for (int i = 0; i < m_contexts.size(); ++i)
+        delete m_matchers[i].load();
+}
+
+void ContextProgram::allocateMatchers()
+{
+    m_matchers.reset(new QAtomicPointer<const ContainerMatcher>[m_contexts.size()]);
+}
+
+const ContainerMatcher *ContextProgram::matcher(int container) const
+{
+    QAtomicPointer<const ContainerMatcher> &slot = m_matchers[container];
+    if (const ContainerMatcher *matcher = slot.loadAcquire())
+        return matcher;
+
+    // Threads entering the container at once may both build it, only one is kept
+    const ContainerMatcher *matcher = new ContainerMatcher(*this, container);
+    if (slot.testAndSetOrdered(nullptr, matcher))
+        return matcher;
+    delete matcher;
+    return slot.loadAcquire();
+}
+
+QString ContextProgram::limitPattern(const QString &pattern)
+{
+    // Empty patterns stand for no regex at all
+    if (pattern.isEmpty() || pattern.startsWith(limitPrefix()))
+        return pattern;
+    return limitPrefix() + pattern;
+}
+
+QString ContextProgram::unlimitPattern(const QString &pattern)
+{
+    if (!pattern.startsWith(limitPrefix()))
+        return pattern;
+    return pattern.mid(limitPrefix().size());
+}
+
+void ContextProgram::save(QDataStream &stream) const
+{
+    stream << qint32(m_contexts.size());
+    for (const Context &context : m_contexts) {
+        stream << context.regex << context.end << context.groupName << qint32(context.groupId)
+               << qint32(context.firstChild) << qint32(context.childCount)
+               << qint32(context.styleIndex) << context.flags << context.type << context.where;
+        stream << bool(context.keyword);
+        if (context.keyword) {
+            const LanguageContextKeyword *keyword = context.keyword;
+            stream << keyword->keywords << keyword->keywordPositions << keyword->words
+                   << keyword->caseInsensitiveWords << keyword->wordRegex;
+        }
+    }
+    stream << m_children << m_names;
+}
+
+QSharedPointer<ContextProgram> ContextProgram::load(QDataStream &stream, int styleCount)
+{
+    QSharedPointer<ContextProgram> program(new ContextProgram);
+    qint32 size;
+    stream >> size;
+    if (size <= 0)
+        stream.setStatus(QDataStream::ReadCorruptData);
+    if (stream.status() != QDataStream::Ok)
+        return QSharedPointer<ContextProgram>();
+
+    for (int i = 0; i < size && stream.status() == QDataStream::Ok; ++i) {
+        Context context;
+        qint32 groupId, firstChild, childCount, styleIndex;
+        bool hasKeyword;
+        stream >> context.regex >> context.end >> context.groupName >> groupId >> firstChild
+            >> childCount >> styleIndex >> context.flags >> context.type >> context.where
+            >> hasKeyword;
+        context.groupId = groupId;
+        context.firstChild = firstChild;
+        context.childCount = childCount;
+        context.styleIndex = styleIndex;
+        context.keyword = nullptr;
+        if (hasKeyword) {
+            auto keyword = QSharedPointer<LanguageContextKeyword>::create();
+            stream >> keyword->keywords >> keyword->keywordPositions >> keyword->words
+                >> keyword->caseInsensitiveWords >> keyword->wordRegex;
+            keyword->extendParent = context.is(ExtendParent);
+            keyword->endParent = context.is(EndParent);
+            keyword->firstLineOnly = context.is(FirstLineOnly);
+            keyword->onceOnly = context.is(OnceOnly);
+            context.keyword = keyword.data();
+            program->m_keywords.append(keyword);
+        }
+        program->m_contexts.append(context);
+    }
+    stream >> program->m_children >> program->m_names;
+    program->m_nodeCount = size;
+
+    // Equal patterns share one compiled regex, as they do when loaded from the spec
+    QHash<QPair<QString, int>, QRegularExpression> pool;
+    auto intern = [&pool](QRegularExpression &regex) {
+        const QPair<QString, int> key(regex.pattern(), int(regex.patternOptions()));
+        auto it = pool.constFind(key);
+        if (it != pool.constEnd())
+            regex = it.value();
+        else
+            pool.insert(key, regex);
+    };
+    for (Context &context : program->m_contexts) {
+        intern(context.regex);
+        intern(context.end);
+    }
+    for (const QSharedPointer<LanguageContextBase> &base : qAsConst(program->m_keywords)) {
+        auto keyword = base.staticCast<LanguageContextKeyword>();
+        for (QRegularExpression &regex : keyword->keywords)
+            intern(regex);
+        intern(keyword->wordRegex);
+    }
+    if (program->m_names.size() != size)
+        stream.setStatus(QDataStream::ReadCorruptData);
+    if (stream.status() != QDataStream::Ok)
+        return QSharedPointer<ContextProgram>();
+
+    /* Children and styles must be within the program and keywords must have
+     * their tables, a damaged file mustn't crash highlighting
+     */
+    for (const Context &context : qAsConst(program->m_contexts)) {
+        if (context.firstChild < 0 || context.childCount < 0
+            || context.firstChild + context.childCount > program->m_children.size()
+            || context.styleIndex < -1 || context.styleIndex >= styleCount
+            || context.type >= LanguageContext::Undefined
+            || (context.type == LanguageContext::Keyword && !context.keyword)) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+            return QSharedPointer<ContextProgram>();
+        }
+    }
+    for (int child : qAsConst(program->m_children)) {
+        if (child < 0 || child >= size) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+            return QSharedPointer<ContextProgram>();
+        }
+    }
+
+    program->allocateMatchers();
+    if (RegexProfile::isEnabled())
+        program->m_profile = QSharedPointer<RegexProfile>::create(program->m_names);
+    return program;
+}
+
+qint64 ContextProgram::warmUp()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const QVector<int> contexts = ownContexts();
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int tasks = qBound(1, pool->maxThreadCount(), contexts.size());
+    QAtomicInt regexCount;
+    QSemaphore done;
+    for (int task = 0; task < tasks; ++task) {
+        pool->start(new FunctionRunnable([this, &contexts, &regexCount, &done, task, tasks]() {
+            int regexes = 0;
+            for (int i = task; i < contexts.size(); i += tasks)
+                regexes += warmUp(contexts.at(i));
+            regexCount.fetchAndAddRelaxed(regexes);
+            done.release();
+        }));
+    }
+    done.acquire(tasks);
+
+    const qint64 elapsed = timer.elapsed();
+    qCDebug(lcContextProgram) << "Prepared" << regexCount.load() << "regexes of" << contexts.size()
+                              << "of" << m_contexts.size() << "contexts in" << elapsed << "ms";
+    return elapsed;
+}
+
+int ContextProgram::warmUp(int index)
+{
+    const Context &context = m_contexts.at(index);
+    int regexes = 0;
+    auto optimize = [&regexes](const QRegularExpression &regex) {
+        if (regex.pattern().isEmpty())
+            return;
+        regex.optimize();
+        ++regexes;
+    };
+
+    optimize(context.regex);
+    // End regexes referring to the start match are only complete once it's known
+    if (!context.end.pattern().contains(QLatin1String("@start}")))
+        optimize(context.end);
+    if (context.keyword) {
+        for (const QRegularExpression &keyword : qAsConst(context.keyword->keywords))
+            optimize(keyword);
+        optimize(context.keyword->wordRegex);
+    }
+    if (context.type == LanguageContext::Container && !context.is(IncludesOnly))
+        regexes += matcher(index)->optimize();
+    return regexes;
+}
+
+QVector<int> ContextProgram::ownContexts() const
+{
+    // Main contexts of other languages are named like js:js
+    const QString name = m_names.at(0);
+    const QStringRef language = name.leftRef(name.indexOf(QLatin1Char(':')));
+    auto isEmbedded = [this, &language](int index) {
+        const QString &id = m_names.at(index);
+        const int colon = id.indexOf(QLatin1Char(':'));
+        return colon > 0 && id.leftRef(colon) != language
+            && id.midRef(colon + 1) == id.leftRef(colon);
+    };
+
+    QVector<bool> seen(m_contexts.size(), false);
+    QVector<int> result = { 0 };
+    seen[0] = true;
+    for (int i = 0; i < result.size(); ++i) {
+        const Context &context = m_contexts.at(result.at(i));
+        for (int c = 0; c < context.childCount; ++c) {
+            const int index = child(context, c);
+            if (seen.at(index))
+                continue;
+            seen[index] = true;
+            if (!isEmbedded(index))
+                result.append(index);
+        }
+    }
+    return result;
+}
+
+int ContextProgram::indexOf(const QSharedPointer<LanguageContext> &context, const QString &path)
+{
+    auto it = m_indices.constFind(context.data());
+    if (it != m_indices.constEnd())
+        return it.value();
+
+    // References to the same context with the same style are compiled once
+    const QPair<const LanguageContextBase *, int> key(context->base.data(), context->styleIndex);
+    auto shared = m_shared.constFind(key);
+    if (shared != m_shared.constEnd()) {
+        m_indices.insert(context.data(), shared.value());
+        return shared.value();
+    }
+
+    int index = m_queue.size();
+    m_indices.insert(context.data(), index);
+    m_shared.insert(key, index);
+    m_queue.append(context);
+    m_names.append(context->id.isEmpty() ? path : context->id);
+    return index;
+}
+
+void ContextProgram::compile(const QSharedPointer<LanguageContext> &context)
+{
+    Context record;
+    record.keyword = nullptr;
+    record.groupId = 0;
+    record.firstChild = m_children.size();
+    record.childCount = 0;
+    record.styleIndex = context->styleIndex;
+    record.flags = 0;
+    record.type = context->type;
+    record.where = LanguageContextSubPattern::Default;
+
+    QList<QSharedPointer<LanguageContext>> children;
+    switch (context->type) {
+    case LanguageContext::Simple: {
+        auto simple = context->base.staticCast<LanguageContextSimple>();
+        record.regex = withLimits(simple->match);
+        record.flags = (simple->extendParent ? ExtendParent : 0) | (simple->endParent ? EndParent : 0)
+            | (simple->firstLineOnly ? FirstLineOnly : 0) | (simple->onceOnly ? OnceOnly : 0);
+        children = simple->includes;
+        break;
+    }
+    case LanguageContext::Container: {
+        auto container = context->base.staticCast<LanguageContextContainer>();
+        record.regex = withLimits(container->start);
+        record.end = withLimits(container->end);
+        record.flags = (container->extendParent ? ExtendParent : 0)
+            | (container->endParent ? EndParent : 0)
+            | (container->firstLineOnly ? FirstLineOnly : 0)
+            | (container->onceOnly ? OnceOnly : 0) | (container->styleInside ? StyleInside : 0)
+            | (container->endAtLineEnd ? EndAtLineEnd : 0)
+            | (container->includesOnly ? IncludesOnly : 0);
+        children = container->includes;
+        break;
+    }
+    case LanguageContext::SubPattern: {
+        auto subPattern = context->base.staticCast<LanguageContextSubPattern>();
+        record.groupId = subPattern->groupId;
+        record.groupName = subPattern->groupName;
+        record.where = subPattern->where;
+        break;
+    }
+    case LanguageContext::Keyword: {
+        auto source = context->base.staticCast<LanguageContextKeyword>();
+        // The context of the spec stays as it is, the program keeps a copy with limits
+        auto keyword = QSharedPointer<LanguageContextKeyword>::create();
+        for (const QRegularExpression &regex : qAsConst(source->keywords))
+            keyword->keywords.append(withLimits(regex));
+        keyword->keywordPositions = source->keywordPositions;
+        keyword->words = source->words;
+        keyword->caseInsensitiveWords = source->caseInsensitiveWords;
+        keyword->wordRegex = withLimits(source->wordRegex);
+        keyword->extendParent = source->extendParent;
+        keyword->endParent = source->endParent;
+        keyword->firstLineOnly = source->firstLineOnly;
+        keyword->onceOnly = source->onceOnly;
+        record.keyword = keyword.data();
+        record.flags = (keyword->extendParent ? ExtendParent : 0)
+            | (keyword->endParent ? EndParent : 0) | (keyword->firstLineOnly ? FirstLineOnly : 0)
+            | (keyword->onceOnly ? OnceOnly : 0);
+        m_keywords.append(keyword);
+        break;
+    }
+    default: {
+        break;
+    }
+    }
+
+    const QString name = m_names.at(m_contexts.size());
+    for (int i = 0; i < children.size(); ++i)
+        m_children.append(indexOf(children.at(i), name + QLatin1Char('/') + QString::number(i)));
+    record.childCount = children.size();
+    m_contexts.append(record);
+}
+
+QRegularExpression ContextProgram::withLimits(const QRegularExpression &regex)
+{
+    // Equal patterns keep sharing one compiled regex, as the loader made them
+    const QPair<QString, int> key(limitPattern(regex.pattern()), int(regex.patternOptions()));
+    auto it = m_limited.constFind(key);
+    if (it != m_limited.constEnd())
+        return it.value();
+    const QRegularExpression limited(key.first, regex.patternOptions());
+    m_limited.insert(key, limited);
+    return limited;
+}
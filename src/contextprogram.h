@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONTEXTPROGRAM_H
+#define CONTEXTPROGRAM_H
+
+#include <QAtomicPointer>
+#include <QDataStream>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include <QString>
+#include <QSharedPointer>
+#include <QRegularExpression>
+#include <QScopedArrayPointer>
+#include "languagecontext.h"
+#include "languagecontextkeyword.h"
+#include "regexprofile.h"
+
+class ContainerMatcher;
+
+/* The context tree of a language flattened into an array.
+ * Contexts refer to each other by index, the main context comes first.
+ * The program doesn't change once built, so any number of threads may read it.
+ */
+class ContextProgram
+{
+    Q_DISABLE_COPY(ContextProgram)
+public:
+    enum Flag : quint16 {
+        ExtendParent = 0x01,
+        EndParent = 0x02,
+        FirstLineOnly = 0x04,
+        OnceOnly = 0x08,
+        StyleInside = 0x10,
+        EndAtLineEnd = 0x20,
+        IncludesOnly = 0x40
+    };
+
+    struct Context
+    {
+        // Match of simple contexts and start of containers
+        QRegularExpression regex;
+        QRegularExpression end;
+        const LanguageContextKeyword *keyword;
+        QString groupName;
+        int groupId;
+        // Includes of containers and sub-patterns of simple contexts
+        int firstChild;
+        int childCount;
+        int styleIndex;
+        quint16 flags;
+        quint8 type;
+        quint8 where;
+
+        inline bool is(Flag flag) const { return (flags & flag) != 0; }
+    };
+
+    explicit ContextProgram(const QSharedPointer<LanguageContext> &mainContext);
+    ~ContextProgram();
+
+    /* Writes the program without any compiled state, load() reads it back.
+     * Style indices must be below styleCount, the number of styles saved along.
+     * The stream status tells whether loading succeeded, null is returned otherwise.
+     */
+    void save(QDataStream &stream) const;
+    static QSharedPointer<ContextProgram> load(QDataStream &stream, int styleCount);
+
+    /* Compiles and JIT-optimizes the regexes of the program and builds the
+     * combined matchers of its containers, spread over the global thread pool.
+     * Otherwise this happens on first use, which is while highlighting.
+     * Embedded languages, such as the scripts of an HTML file, are left to
+     * first use, so documents which never enter them don't pay for them.
+     * Must be called before the program is shared. Returns the milliseconds taken.
+     */
+    qint64 warmUp();
+    /* The id of the context in the spec, anonymous contexts are named
+     * after the path to them, such as c:c/3
+     */
+    inline QString name(int index) const { return m_names.at(index); }
+    // Null unless profiling is enabled, see RegexProfile
+    inline RegexProfile *profile() const { return m_profile.data(); }
+    /* All patterns of the program start with PCRE limits, so a regex which
+     * backtracks too much fails instead of stalling highlighting. A valid
+     * regex then returns an invalid match. These add and remove the limits.
+     */
+    static QString limitPattern(const QString &pattern);
+    static QString unlimitPattern(const QString &pattern);
+    // Built once, when first asked for by any thread
+    const ContainerMatcher *matcher(int container) const;
+
+    inline int size() const { return m_contexts.size(); }
+    // Nodes of the context graph the program was built from, before equal ones were merged
+    inline int nodeCount() const { return m_nodeCount; }
+    inline const Context &context(int index) const { return m_contexts.at(index); }
+    inline int child(const Context &context, int i) const
+    {
+        return m_children.at(context.firstChild + i);
+    }
+
+private:
+    ContextProgram() = default;
+    int indexOf(const QSharedPointer<LanguageContext> &context, const QString &path);
+    void compile(const QSharedPointer<LanguageContext> &context);
+    QRegularExpression withLimits(const QRegularExpression &regex);
+    int warmUp(int index);
+    QVector<int> ownContexts() const;
+    void allocateMatchers();
+
+    QVector<Context> m_contexts;
+    QVector<int> m_children;
+    // Keyword contexts keep their word tables, which must outlive the program
+    QVector<QSharedPointer<LanguageContextBase>> m_keywords;
+    // Combined matchers of the containers, by context index
+    mutable QScopedArrayPointer<QAtomicPointer<const ContainerMatcher>> m_matchers;
+    QStringList m_names;
+    QSharedPointer<RegexProfile> m_profile;
+    int m_nodeCount = 0;
+
+    // Only used while building
+    QHash<const LanguageContext *, int> m_indices;
+    QHash<QPair<const LanguageContextBase *, int>, int> m_shared;
+    QVector<QSharedPointer<LanguageContext>> m_queue;
+    QHash<QPair<QString, int>, QRegularExpression> m_limited;
+};
+
+#endif // CONTEXTPROGRAM_H
@@ -20,19 +20,36 @@
 #include "documenthandler.h"
 
 #include <QTextDocument>
+#include <QCoreApplication>
 #include <QFileInfo>
 #include <QMimeDatabase>
+#include <QPointer>
 #include <QTextDocumentFragment>
 #include <QDebug>
-#include "languageloader.h"
+#include "functionrunnable.h"
+#include "languagecache.h"
 #include "languagemanager.h"
 
+// Files up to this size get all features
+static const qint64 FullTierSize = 4 * 1024 * 1024;
+// Lines longer than this are slow to lay out and are skipped by the highlighter anyway
+static const int FullTierLineLength = 20000;
+// Beyond these there is no highlighting and no wrapping
+static const qint64 PlainTierSize = 64 * 1024 * 1024;
+static const int PlainTierLineLength = 1000000;
+// Larger files don't fit into a QString
+static const qint64 MaxFileSize = 512 * 1024 * 1024;
+
 DocumentHandler::DocumentHandler(QObject *parent)
     : QObject(parent)
     , m_target(0)
     , m_document(0)
     , m_highlighter(0)
+    , m_tier(FullTier)
+    , m_languageRevision(QSharedPointer<QAtomicInt>::create(0))
 {
+    // Languages are loaded one at a time, the last one asked for is the one that counts
+    m_languagePool.setMaxThreadCount(1);
 
 #ifndef QT_NO_FILESYSTEMWATCHER
     m_watcher = new QFileSystemWatcher(this);
@@ -46,6 +63,8 @@ DocumentHandler::DocumentHandler(QObject *parent)
 
 DocumentHandler::~DocumentHandler()
 {
+    // Loads that haven't started yet are skipped, the pool waits for the others
+    m_languageRevision->ref();
 #ifndef QT_NO_FILESYSTEMWATCHER
     delete m_watcher;
 #endif
@@ -70,6 +89,7 @@ void DocumentHandler::setTarget(QQuickItem *target)
                 delete m_highlighter;
             m_highlighter = new LiriSyntaxHighlighter(m_document);
             m_highlighter->setDefaultStyles(m_defStyles);
+            applyTier(m_tier);
         }
     }
     emit targetChanged();
@@ -91,23 +111,27 @@ bool DocumentHandler::setFileUrl(const QUrl &fileUrl)
             emit error(file.errorString());
             return false;
         }
+        if (file.size() > MaxFileSize) {
+            emit error(tr("The file is too large to be opened"));
+            return false;
+        }
         QByteArray data = file.readAll();
         if (file.error() != QFileDevice::NoError) {
             emit error(file.errorString());
             file.close();
             return false;
         }
-        QTextCodec *codec = QTextCodec::codecForUtfText(data, QTextCodec::codecForLocale());
-        setText(codec->toUnicode(data));
+        // Don't highlight the new text with the previous language
+        if (m_highlighter)
+            m_highlighter->setLanguage(QSharedPointer<const CompiledLanguage>());
+        // Detected along with loading the language, see updateHighlighting()
+        m_mimeType = QMimeType();
+        // Opening a file doesn't reload the language like setTier() does
+        applyTier(tierFor(data));
+        loadText(data);
         if (m_document) {
             m_document->setModified(false);
-
-            // Enable syntax highlighting
-            QMimeDatabase db;
-            QMimeType mimeType = db.mimeTypeForFileNameAndData(m_fileUrl.toString(), data);
-            LanguageLoader ll(m_defStyles);
-            auto language = ll.loadMainContextByMimeType(mimeType, m_fileUrl.fileName());
-            m_highlighter->setLanguage(language, ll.styleMap());
+            updateHighlighting();
         }
         if (m_fileUrl.isEmpty())
             m_documentTitle = QStringLiteral("New Document");
@@ -128,9 +152,113 @@ void DocumentHandler::setDocumentTitle(const QString &title)
     }
 }
 
-QString DocumentHandler::textFragment(int position, int blockCount)
+void DocumentHandler::setTier(Tier tier)
 {
+    if (tier == m_tier)
+        return;
+
+    const bool wasPlain = m_tier == PlainTier;
+    applyTier(tier);
+    // The language has to be loaded again after plain text
+    if (wasPlain || m_tier == PlainTier)
+        updateHighlighting();
+}
+
+void DocumentHandler::applyTier(Tier tier)
+{
+    if (tier != m_tier) {
+        m_tier = tier;
+        emit tierChanged();
+    }
     if (m_highlighter) {
+        // Plain text isn't worth the cost of QSyntaxHighlighter following every edit
+        m_highlighter->setEnabled(m_tier != PlainTier);
+        m_highlighter->setViewportOnly(m_tier == ViewportTier);
+    }
+}
+
+DocumentHandler::Tier DocumentHandler::tierFor(const QByteArray &data)
+{
+    int longestLine = 0;
+    for (int start = 0; start < data.size();) {
+        int end = data.indexOf('\n', start);
+        if (end < 0)
+            end = data.size();
+        longestLine = qMax(longestLine, end - start);
+        start = end + 1;
+    }
+
+    if (data.size() > PlainTierSize || longestLine > PlainTierLineLength)
+        return PlainTier;
+    if (data.size() > FullTierSize || longestLine > FullTierLineLength)
+        return ViewportTier;
+    return FullTier;
+}
+
+void DocumentHandler::loadText(QByteArray &data)
+{
+    QTextCodec *codec = QTextCodec::codecForUtfText(data, QTextCodec::codecForLocale());
+    QString text = codec->toUnicode(data);
+    // Don't keep both copies around
+    data.clear();
+
+    if (m_tier == FullTier || !m_document) {
+        setText(text);
+        return;
+    }
+
+    // Large texts go into the document directly instead of through the text property
+    m_text.clear();
+    m_document->setPlainText(text);
+}
+
+void DocumentHandler::updateHighlighting()
+{
+    // Any language still being loaded is for the previous file or tier
+    const int revision = m_languageRevision->fetchAndAddOrdered(1) + 1;
+    if (!m_document || !m_highlighter)
+        return;
+
+    if (m_tier == PlainTier || m_fileUrl.isEmpty()) {
+        m_highlighter->setLanguage(QSharedPointer<const CompiledLanguage>());
+        return;
+    }
+
+    // The text is shown meanwhile, the highlighter gets the language once it's loaded
+    const QString path = m_fileUrl.toLocalFile();
+    const QMimeType knownMimeType = m_mimeType;
+    QSharedPointer<QAtomicInt> currentRevision = m_languageRevision;
+    QPointer<DocumentHandler> handler(this);
+    m_languagePool.start(new FunctionRunnable([=]() {
+        if (currentRevision->load() != revision)
+            return;
+        const QMimeType mimeType =
+            knownMimeType.isValid() ? knownMimeType : QMimeDatabase().mimeTypeForFile(path);
+        if (currentRevision->load() != revision)
+            return;
+        const QSharedPointer<const CompiledLanguage> language =
+            LanguageCache::getInstance()->languageForMimeType(mimeType, QFileInfo(path).fileName());
+        QMetaObject::invokeMethod(qApp,
+                                  [handler, revision, mimeType, language]() {
+                                      if (handler)
+                                          handler->setLanguage(revision, mimeType, language);
+                                  },
+                                  Qt::QueuedConnection);
+    }));
+}
+
+void DocumentHandler::setLanguage(int revision, const QMimeType &mimeType,
+                                  QSharedPointer<const CompiledLanguage> language)
+{
+    if (revision != m_languageRevision->load() || !m_highlighter)
+        return;
+    m_mimeType = mimeType;
+    m_highlighter->setLanguage(language);
+}
+
+QString DocumentHandler::textFragment(int position, int blockCount)
+{
+    if (m_highlighter && m_highlighter->isEnabled()) {
         return m_highlighter->highlightedFragment(position, blockCount, m_document->defaultFont());
     } else {
         QTextCursor cursor(m_document->findBlock(position));
@@ -147,6 +275,15 @@ QString DocumentHandler::textFragment(int position, int blockCount)
     }
 }
 
+void DocumentHandler::setVisibleRange(int startPosition, int endPosition)
+{
+    if (!m_document || !m_highlighter)
+        return;
+
+    m_highlighter->setVisibleBlocks(m_document->findBlock(startPosition).blockNumber(),
+                                    m_document->findBlock(endPosition).blockNumber());
+}
+
 void DocumentHandler::setText(const QString &text)
 {
     if (text != m_text) {
@@ -198,17 +335,25 @@ bool DocumentHandler::reloadText()
         emit error(file.errorString());
         return false;
     }
+    if (file.size() > MaxFileSize) {
+        emit error(tr("The file is too large to be opened"));
+        return false;
+    }
     QByteArray data = file.readAll();
-    QTextCodec *codec = QTextCodec::codecForUtfText(data, QTextCodec::codecForLocale());
-    setText(codec->toUnicode(data));
-    if (file.error() == QFileDevice::NoError) {
-        file.close();
-        return true;
-    } else {
+    if (file.error() != QFileDevice::NoError) {
         emit error(file.errorString());
         file.close();
         return false;
     }
+    file.close();
+    // Same as opening the file, the new text mustn't be highlighted with stale states
+    if (m_highlighter)
+        m_highlighter->setLanguage(QSharedPointer<const CompiledLanguage>());
+    // The file may have grown past the limits of its tier, or shrunk below them
+    applyTier(tierFor(data));
+    loadText(data);
+    updateHighlighting();
+    return true;
 }
 
 void DocumentHandler::fileChanged(const QString &file)
@@ -24,6 +24,9 @@
 #include <QQuickTextDocument>
 #include <QTextCodec>
 #include <QFile>
+#include <QMimeType>
+#include <QAtomicInt>
+#include <QThreadPool>
 #ifndef QT_NO_FILESYSTEMWATCHER
 #include <QFileSystemWatcher>
 #endif
@@ -39,8 +42,21 @@ class DocumentHandler : public QObject
     Q_PROPERTY(
         QString documentTitle READ documentTitle WRITE setDocumentTitle NOTIFY documentTitleChanged)
     Q_PROPERTY(bool modified READ modified NOTIFY modifiedChanged)
+    Q_PROPERTY(Tier tier READ tier WRITE setTier NOTIFY tierChanged)
 
 public:
+    /* Features enabled for the document. Opening a file picks one by its size
+     * and the length of its lines, the user may change it afterwards.
+     */
+    enum Tier {
+        FullTier,
+        // Only the visible part of the document is highlighted
+        ViewportTier,
+        // No highlighting and no wrapping
+        PlainTier
+    };
+    Q_ENUM(Tier)
+
     DocumentHandler(QObject *parent = nullptr);
     ~DocumentHandler();
 
@@ -58,7 +74,11 @@ public:
 
     inline bool modified() { return m_document->isModified(); }
 
+    inline Tier tier() { return m_tier; }
+    void setTier(Tier tier);
+
     Q_INVOKABLE QString textFragment(int position, int blockCount);
+    Q_INVOKABLE void setVisibleRange(int startPosition, int endPosition);
 
 signals:
     void targetChanged();
@@ -67,6 +87,7 @@ signals:
     void documentTitleChanged();
     void fileChangedOnDisk();
     void modifiedChanged();
+    void tierChanged();
     void error(const QString &description);
 
 public slots:
@@ -77,6 +98,15 @@ private slots:
     void fileChanged(const QString &file);
 
 private:
+    static Tier tierFor(const QByteArray &data);
+    // Sets the tier and what it means for the highlighter, but not the language
+    void applyTier(Tier tier);
+    void loadText(QByteArray &data);
+    // Loads the language in the background
+    void updateHighlighting();
+    void setLanguage(int revision, const QMimeType &mimeType,
+                     QSharedPointer<const CompiledLanguage> language);
+
     QQuickItem *m_target;
     QTextDocument *m_document;
 #ifndef QT_NO_FILESYSTEMWATCHER
@@ -88,8 +118,13 @@ private:
     QSharedPointer<LanguageDefaultStyles> m_defStyles;
 
     QUrl m_fileUrl;
+    QMimeType m_mimeType;
     QString m_text;
     QString m_documentTitle;
+    Tier m_tier;
+    // Bumped whenever the language loaded in the background is no longer wanted
+    QSharedPointer<QAtomicInt> m_languageRevision;
+    QThreadPool m_languagePool;
 };
 
 #endif // DOCUMENTHANDLER_H
@@ -1,5 +1,5 @@
 /*
- * Copyright © 2016-2017 Andrew Penkrat
+ * Copyright © 2017 Andrew Penkrat
  *
  * This file is part of Liri Text.
  *
@@ -17,31 +17,27 @@
  * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef HIGHLIGHTDATA_H
-#define HIGHLIGHTDATA_H
+#ifndef FUNCTIONRUNNABLE_H
+#define FUNCTIONRUNNABLE_H
 
-#include <QTextBlockUserData>
-#include <QHash>
-#include <QRegularExpressionMatch>
-#include "languagecontext.h"
+#include <QRunnable>
+#include <functional>
 
-class HighlightData : public QTextBlockUserData
+/* Runs a function on a QThreadPool, which deletes it once done.
+ * QRunnable::create() does the same, but only from Qt 5.15 on.
+ */
+class FunctionRunnable : public QRunnable
 {
-    Q_DISABLE_COPY(HighlightData)
 public:
-    HighlightData();
-    ~HighlightData();
-
-    struct ContainerInfo
+    explicit FunctionRunnable(const std::function<void()> &function)
+        : m_function(function)
     {
-        QSharedPointer<LanguageContext> containerRef;
-        QRegularExpression endRegex;
-        QList<QSharedPointer<LanguageContext>> forbiddenContexts;
-    };
+    }
 
-    QList<ContainerInfo> containers;
-};
+    void run() override { m_function(); }
 
-uint qHash(const HighlightData::ContainerInfo &t, uint seed = 0);
+private:
+    std::function<void()> m_function;
+};
 
-#endif // HIGHLIGHTDATA_H
+#endif // FUNCTIONRUNNABLE_H
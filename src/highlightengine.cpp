@@ -0,0 +1,520 @@
+/*
+ * Copyright © 2016-2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QRegularExpression>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QDebug>
+#include "highlightengine.h"
+#include "languagecontextkeyword.h"
+#include "languagecontextcontainer.h"
+#include "languagecontextsimple.h"
+#include "languagecontextsubpattern.h"
+
+// Longer lines, such as minified code, are left unformatted
+static const int MaxLineLength = 20000;
+/* Match steps, each finding the next token, one line may take. The limits of
+ * ContextProgram::limitPattern() end a single runaway match, this stops lines
+ * which need a lot of them. Counting steps instead of time keeps the outcome
+ * independent of the load, so a line is skipped the same way in every chunk
+ * and every run.
+ */
+static const int MaxLineSteps = 10000;
+
+HighlightEngine::HighlightEngine(QSharedPointer<const ContextProgram> program,
+                                 const QVector<QTextCharFormat> &formats,
+                                 QSharedPointer<HighlightStateTable> states)
+    : m_program(program)
+    , m_formats(formats)
+    , m_states(states)
+    , m_firstLine(false)
+    , m_collectFormats(true)
+    , m_limitExceeded(false)
+{
+}
+
+QStringList HighlightEngine::resolveStyles(const QSharedPointer<LanguageContext> &lang,
+                                           const QHash<QString, QString> &styleMap)
+{
+    QStringList styles;
+    QSet<const LanguageContext *> visited;
+    QList<QSharedPointer<LanguageContext>> contexts = { lang };
+    while (!contexts.isEmpty()) {
+        QSharedPointer<LanguageContext> context = contexts.takeLast();
+        if (!context || visited.contains(context.data()))
+            continue;
+        visited.insert(context.data());
+
+        context->styleIndex = -1;
+        auto style = styleMap.constFind(context->styleId);
+        if (style != styleMap.constEnd()) {
+            context->styleIndex = styles.indexOf(style.value());
+            if (context->styleIndex < 0) {
+                context->styleIndex = styles.size();
+                styles.append(style.value());
+            }
+        }
+
+        if (context->type == LanguageContext::Container)
+            contexts += context->base.staticCast<LanguageContextContainer>()->includes;
+        else if (context->type == LanguageContext::Simple)
+            contexts += context->base.staticCast<LanguageContextSimple>()->includes;
+    }
+    return styles;
+}
+
+HighlightEngine::Result HighlightEngine::highlightLine(const QString &text, int previousState,
+                                                       bool firstLine)
+{
+    m_firstLine = firstLine;
+    m_result = Result();
+    m_limitExceeded = false;
+    if (text.length() > MaxLineLength)
+        return skipLine(previousState);
+
+    int steps = 0;
+    auto containerStack = m_states->state(previousState);
+
+    int start = 0;
+    bool highlightingProgresses = true;
+    startContainer(containerStack, containerStack.first().container, start, text.length());
+
+    /* End matches of the container levels, indexed from the bottom of the stack.
+     * Levels above the current top are gone, so their matches are dropped.
+     */
+    QVector<CachedMatch> endMatches;
+    m_matchCache.clear();
+    RegexProfile *profile = m_program->profile();
+
+    while (highlightingProgresses) {
+        if (++steps > MaxLineSteps)
+            return skipLine(previousState);
+
+        auto &containerInfo = containerStack.first();
+        int containerIdx = 0;
+
+        QRegularExpressionMatch containerEndMatch;
+        endMatches.resize(containerStack.size());
+        for (int i = 0; i < containerStack.size(); ++i) {
+            const ContextProgram::Context &container =
+                m_program->context(containerStack.at(i).container);
+            CachedMatch &cached = endMatches[containerStack.size() - 1 - i];
+            if (!cached.valid
+                || (cached.match.hasMatch() && cached.match.capturedStart() < start)) {
+                QRegularExpressionMatch endMatch;
+                QElapsedTimer timer;
+                if (profile)
+                    timer.start();
+                if (containerStack.at(i).endRegex.pattern() != QLatin1String("")) {
+                    endMatch = containerStack.at(i).endRegex.match(text, start);
+                    checkLimits(containerStack.at(i).endRegex, endMatch);
+                }
+                if (!endMatch.hasMatch() && container.is(ContextProgram::EndAtLineEnd))
+                    endMatch = QRegularExpression(QStringLiteral("$")).match(text, start);
+                if (profile)
+                    profile->record(RegexProfile::End, containerStack.at(i).container,
+                                    endMatch.hasMatch(), timer.nsecsElapsed());
+                cached.match = endMatch;
+                cached.valid = true;
+            }
+
+            const QRegularExpressionMatch &tmp = cached.match;
+            if (tmp.hasMatch()
+                && (!containerEndMatch.hasMatch()
+                    || tmp.capturedStart() <= containerEndMatch.capturedStart())) {
+                containerIdx = i;
+                containerEndMatch = tmp;
+            }
+            if (container.is(ContextProgram::ExtendParent))
+                break;
+        }
+
+        Match bestMatch = findMatch(text, start,
+                                    containerEndMatch.hasMatch() ? containerEndMatch.capturedStart()
+                                                                 : text.length(),
+                                    containerInfo.container, containerInfo);
+        // Where a regex gave up, the tokens of the line are unknown
+        if (m_limitExceeded)
+            return skipLine(previousState);
+
+        if (!bestMatch.match.hasMatch()) {
+            if (!containerEndMatch.hasMatch()) {
+                start = text.length();
+                highlightingProgresses = false;
+                continue;
+            } else {
+                start = containerEndMatch.capturedEnd();
+                endNthContainer(containerStack, containerIdx, start, text.length(),
+                                containerEndMatch);
+                continue;
+            }
+        } else if (containerEndMatch.hasMatch()
+                   && containerEndMatch.capturedStart() <= bestMatch.match.capturedStart()) {
+            start = containerEndMatch.capturedEnd();
+            endNthContainer(containerStack, containerIdx, start, text.length(), containerEndMatch);
+            continue;
+        }
+
+        const ContextProgram::Context &context = m_program->context(bestMatch.context);
+        if (context.is(ContextProgram::OnceOnly))
+            forbid(containerInfo, bestMatch.context);
+
+        switch (context.type) {
+        case LanguageContext::Keyword: {
+            if (context.styleIndex >= 0)
+                setFormat(bestMatch.match.capturedStart(), bestMatch.match.capturedLength(),
+                          m_formats.at(context.styleIndex));
+
+            start = bestMatch.match.capturedEnd();
+
+            if (context.is(ContextProgram::EndParent))
+                endNthContainer(containerStack, 0, start, text.length());
+            break;
+        }
+        case LanguageContext::Simple: {
+            if (context.styleIndex >= 0)
+                setFormat(bestMatch.match.capturedStart(), bestMatch.match.capturedLength(),
+                          m_formats.at(context.styleIndex));
+
+            start = bestMatch.match.capturedEnd();
+
+            for (int i = 0; i < context.childCount; ++i) {
+                const ContextProgram::Context &inc =
+                    m_program->context(m_program->child(context, i));
+                if (inc.type == LanguageContext::SubPattern) {
+                    int mStart = inc.groupName.isNull()
+                        ? bestMatch.match.capturedStart(inc.groupId)
+                        : bestMatch.match.capturedStart(inc.groupName);
+                    int mLen = inc.groupName.isNull() ? bestMatch.match.capturedLength(inc.groupId)
+                                                      : bestMatch.match.capturedLength(inc.groupName);
+                    if (inc.styleIndex >= 0)
+                        setFormat(mStart, mLen, m_formats.at(inc.styleIndex));
+                }
+            }
+            if (context.is(ContextProgram::EndParent))
+                endNthContainer(containerStack, 0, start, text.length());
+            break;
+        }
+        case LanguageContext::Container: {
+            start = bestMatch.match.capturedEnd();
+            startContainer(containerStack, bestMatch.context, start, text.length(),
+                           bestMatch.match);
+            break;
+        }
+        default: {
+            qDebug() << "Internal error during highlighting";
+            qDebug() << "Impossible context type";
+            Q_ASSERT(false);
+        }
+        }
+    }
+
+    m_result.state = m_states->intern(containerStack);
+    return m_result;
+}
+
+QSharedPointer<HighlightEngine> HighlightEngine::clone() const
+{
+    return QSharedPointer<HighlightEngine>::create(m_program, m_formats, m_states);
+}
+
+HighlightEngine::Result HighlightEngine::skipLine(int previousState)
+{
+    // The next line goes on in the containers this one started in
+    m_result = Result();
+    m_result.state = m_states->intern(m_states->state(previousState));
+    m_result.skipped = true;
+    return m_result;
+}
+
+int HighlightEngine::lineState(const QString &text, int previousState, bool firstLine)
+{
+    m_collectFormats = false;
+    int state = highlightLine(text, previousState, firstLine).state;
+    m_collectFormats = true;
+    return state;
+}
+
+void HighlightEngine::endNthContainer(HighlightStateTable::State &containers, int n, int offset,
+                                      int length, const QRegularExpressionMatch &endMatch)
+{
+    for (int i = 0; i < n; ++i)
+        containers.removeFirst();
+
+    if (endMatch.hasMatch()) {
+        const ContextProgram::Context &container =
+            m_program->context(containers.first().container);
+        for (int i = 0; i < container.childCount; ++i) {
+            const ContextProgram::Context &inc =
+                m_program->context(m_program->child(container, i));
+            if (inc.type == LanguageContext::SubPattern
+                && inc.where == LanguageContextSubPattern::End) {
+                int endStart = inc.groupName.isNull() ? endMatch.capturedStart(inc.groupId)
+                                                      : endMatch.capturedStart(inc.groupName);
+                if (endStart >= 0) {
+                    int endLen = inc.groupName.isNull() ? endMatch.capturedLength(inc.groupId)
+                                                        : endMatch.capturedLength(inc.groupName);
+                    if (inc.styleIndex >= 0)
+                        setFormat(endStart, endLen, m_formats.at(inc.styleIndex));
+                }
+            }
+        }
+    }
+
+    while (m_program->context(containers.first().container).is(ContextProgram::EndParent))
+        containers.removeFirst();
+    containers.removeFirst();
+    startContainer(containers, containers.first().container, offset, length);
+}
+
+void HighlightEngine::startContainer(HighlightStateTable::State &containers, int containerIndex,
+                                     int offset, int length,
+                                     const QRegularExpressionMatch &startMatch)
+{
+    const ContextProgram::Context &container = m_program->context(containerIndex);
+    int start = startMatch.hasMatch() ? startMatch.capturedStart() : offset;
+    // Unstyled containers take the style of the closest styled one below them
+    const int styleIndex =
+        container.styleIndex >= 0 ? container.styleIndex : containers.first().styleIndex;
+    // Highlight the whole text
+    setFormat(container.is(ContextProgram::StyleInside) ? offset : start, length,
+              styleIndex >= 0 ? m_formats.at(styleIndex) : QTextCharFormat());
+
+    if (startMatch.hasMatch()) {
+        // Resolve references to start subpatterns from end regex
+        QRegularExpression endRegex = container.end;
+        QString endPattern = endRegex.pattern();
+        QRegularExpression startRefRegex = QRegularExpression(QStringLiteral("\\\\%{(.+?)@start}"));
+        QRegularExpressionMatch startRefMatch;
+        while ((startRefMatch = startRefRegex.match(endPattern)).hasMatch()) {
+            QString groupName = startRefMatch.captured(1);
+            bool isId;
+            int id = groupName.toInt(&isId);
+            endPattern.replace(startRefMatch.capturedStart(), startRefMatch.capturedLength(),
+                               QRegularExpression::escape(isId ? startMatch.captured(id)
+                                                               : startMatch.captured(groupName)));
+        }
+        if (endRegex.pattern() != endPattern) // Don't make regex dirty if there were no changes
+            endRegex.setPattern(endPattern);
+
+        // Highlight start subpatterns
+        for (int i = 0; i < container.childCount; ++i) {
+            const ContextProgram::Context &inc =
+                m_program->context(m_program->child(container, i));
+            if (inc.type == LanguageContext::SubPattern
+                && inc.where == LanguageContextSubPattern::Start) {
+                int startStart = inc.groupName.isNull() ? startMatch.capturedStart(inc.groupId)
+                                                        : startMatch.capturedStart(inc.groupName);
+                if (startStart >= 0) {
+                    int startLen = inc.groupName.isNull()
+                        ? startMatch.capturedLength(inc.groupId)
+                        : startMatch.capturedLength(inc.groupName);
+                    if (inc.styleIndex >= 0)
+                        setFormat(startStart, startLen, m_formats.at(inc.styleIndex));
+                }
+            }
+        }
+        containers.prepend({ containerIndex, endRegex, QBitArray(), styleIndex });
+    }
+}
+
+HighlightEngine::Match HighlightEngine::findMatch(
+    const QString &text, int offset, int potentialEnd, int contextIndex,
+    HighlightStateTable::ContainerInfo &currentContainerInfo, bool rootContext)
+{
+    const ContextProgram::Context &context = m_program->context(contextIndex);
+    if (context.type == LanguageContext::SubPattern)
+        return { QRegularExpressionMatch(), -1, 0 };
+    if (context.is(ContextProgram::FirstLineOnly) && !m_firstLine)
+        return { QRegularExpressionMatch(), -1, 0 };
+    if (context.is(ContextProgram::OnceOnly) && isForbidden(currentContainerInfo, contextIndex))
+        return { QRegularExpressionMatch(), -1, 0 };
+
+    QStringRef allowedText = QStringRef(&text);
+    if (!context.is(ContextProgram::ExtendParent))
+        allowedText = allowedText.left(potentialEnd);
+
+    switch (context.type) {
+    case LanguageContext::Keyword: {
+        const LanguageContextKeyword *keywordContext = context.keyword;
+        QElapsedTimer timer;
+        if (m_program->profile())
+            timer.start();
+
+        // Keywords of the same context starting at the same place win in their original order
+        Match bestMatch = { QRegularExpressionMatch(), contextIndex, 0 };
+        bestMatch.match = keywordContext->matchWord(allowedText, offset, &bestMatch.order);
+        if (!bestMatch.match.isValid())
+            m_limitExceeded = true;
+        for (int i = 0; i < keywordContext->keywords.size(); ++i) {
+            const QRegularExpression &keyword = keywordContext->keywords.at(i);
+            if (keyword.pattern().isEmpty() && offset >= text.length())
+                continue;
+            QRegularExpressionMatch kwMatch = keyword.match(allowedText, offset);
+            checkLimits(keyword, kwMatch);
+            if (kwMatch.hasMatch()) {
+                Match match = { kwMatch, contextIndex, keywordContext->keywordPositions.at(i) };
+                if (match < bestMatch)
+                    bestMatch = match;
+            }
+        }
+        bestMatch.order = 0;
+        if (m_program->profile())
+            m_program->profile()->record(RegexProfile::Match, contextIndex,
+                                         bestMatch.match.hasMatch(), timer.nsecsElapsed());
+        return bestMatch;
+    }
+    case LanguageContext::Simple: {
+        if (context.regex.pattern().isEmpty() && offset >= text.length())
+            break;
+
+        return { profiledMatch(context.regex, allowedText, offset, contextIndex), contextIndex,
+                 0 };
+    }
+    case LanguageContext::Container: {
+        if (context.regex.pattern().isEmpty() && offset >= text.length())
+            break;
+
+        if (rootContext && offset < text.length())
+            return findCombinedMatch(text, offset, potentialEnd, contextIndex,
+                                     currentContainerInfo);
+
+        if (context.is(ContextProgram::IncludesOnly) || rootContext) {
+            Match bestMatch = { QRegularExpressionMatch(), -1, 0 };
+            for (int i = 0; i < context.childCount; ++i) {
+                Match match = findMatch(text, offset, potentialEnd, m_program->child(context, i),
+                                        currentContainerInfo, false);
+                if (match < bestMatch)
+                    bestMatch = match;
+            }
+            return bestMatch;
+        } else {
+            return { profiledMatch(context.regex, allowedText, offset, contextIndex), contextIndex,
+                     0 };
+        }
+    }
+    default: {
+        break;
+    }
+    }
+
+    return { QRegularExpressionMatch(), -1, 0 };
+}
+
+HighlightEngine::Match HighlightEngine::findCombinedMatch(
+    const QString &text, int offset, int potentialEnd, int contextIndex,
+    HighlightStateTable::ContainerInfo &currentContainerInfo)
+{
+    const ContainerMatcher *matcher = matcherFor(contextIndex);
+    QElapsedTimer timer;
+    if (m_program->profile())
+        timer.start();
+    ContainerMatcher::Result result =
+        matcher->match(text, offset, potentialEnd, &m_matchCache[matcher]);
+    // The combined regexes are valid, so any failure is one over the limits
+    if (!result.match.isValid())
+        m_limitExceeded = true;
+    // A hit is credited to the include which matched, like the fallbacks are
+    if (m_program->profile() && result.match.hasMatch())
+        m_program->profile()->record(RegexProfile::Match, result.context, true,
+                                     timer.nsecsElapsed());
+    else if (m_program->profile())
+        m_program->profile()->record(RegexProfile::Includes, contextIndex, false,
+                                     timer.nsecsElapsed());
+    Match bestMatch = { result.match, result.context, result.order };
+    for (const auto &fallback : matcher->fallbacks()) {
+        Match match = findMatch(text, offset, potentialEnd, fallback.context, currentContainerInfo,
+                                false);
+        match.order = fallback.order;
+        if (match < bestMatch)
+            bestMatch = match;
+    }
+    return bestMatch;
+}
+
+QRegularExpressionMatch HighlightEngine::profiledMatch(const QRegularExpression &regex,
+                                                       const QStringRef &text, int offset,
+                                                       int contextIndex)
+{
+    RegexProfile *profile = m_program->profile();
+    QElapsedTimer timer;
+    if (profile)
+        timer.start();
+    QRegularExpressionMatch match = regex.match(text, offset);
+    if (profile)
+        profile->record(RegexProfile::Match, contextIndex, match.hasMatch(), timer.nsecsElapsed());
+    checkLimits(regex, match);
+    return match;
+}
+
+void HighlightEngine::checkLimits(const QRegularExpression &regex,
+                                  const QRegularExpressionMatch &match)
+{
+    // An invalid regex never matches, which is no reason to give up on the line
+    if (!match.isValid() && regex.isValid())
+        m_limitExceeded = true;
+}
+
+const ContainerMatcher *HighlightEngine::matcherFor(int container)
+{
+    return m_program->matcher(container);
+}
+
+bool HighlightEngine::isForbidden(const HighlightStateTable::ContainerInfo &containerInfo,
+                                  int context)
+{
+    int bit = matcherFor(containerInfo.container)->onceOnlyBit(context);
+    return bit >= 0 && bit < containerInfo.forbiddenContexts.size()
+        && containerInfo.forbiddenContexts.testBit(bit);
+}
+
+void HighlightEngine::forbid(HighlightStateTable::ContainerInfo &containerInfo, int context)
+{
+    const ContainerMatcher *matcher = matcherFor(containerInfo.container);
+    int bit = matcher->onceOnlyBit(context);
+    if (bit < 0)
+        return;
+    // Keep the size fixed, so that equal sets compare equal
+    if (containerInfo.forbiddenContexts.isEmpty())
+        containerInfo.forbiddenContexts.resize(matcher->onceOnlyCount());
+    containerInfo.forbiddenContexts.setBit(bit);
+}
+
+void HighlightEngine::setFormat(int start, int count, const QTextCharFormat &format)
+{
+    if (!m_collectFormats)
+        return;
+
+    QTextLayout::FormatRange range;
+    range.start = start;
+    range.length = count;
+    range.format = format;
+    m_result.formats.append(range);
+}
+
+bool HighlightEngine::Match::operator<(const Match &other)
+{
+    if (!this->match.hasMatch())
+        return false;
+    if (!other.match.hasMatch())
+        return true;
+    if (this->match.capturedStart() == other.match.capturedStart())
+        return this->order < other.order;
+    return this->match.capturedStart() < other.match.capturedStart();
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2016-2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HIGHLIGHTENGINE_H
+#define HIGHLIGHTENGINE_H
+
+#include <QHash>
+#include <QStringList>
+#include <QMetaType>
+#include <QVector>
+#include <QTextLayout>
+#include <QRegularExpressionMatch>
+#include "languagecontext.h"
+#include "containermatcher.h"
+#include "contextprogram.h"
+#include "highlightstatetable.h"
+
+/* Highlights one line at a time without touching the document, so lines can
+ * be highlighted outside of the GUI thread. An engine must only be used by one
+ * thread at a time, but engines may share the language and the state table.
+ */
+class HighlightEngine
+{
+    Q_DISABLE_COPY(HighlightEngine)
+public:
+    struct Result
+    {
+        QVector<QTextLayout::FormatRange> formats;
+        int state = -1;
+        // The line was over the length, step or regex limits and has no formats
+        bool skipped = false;
+    };
+
+    HighlightEngine(QSharedPointer<const ContextProgram> program,
+                    const QVector<QTextCharFormat> &formats,
+                    QSharedPointer<HighlightStateTable> states);
+
+    /* Sets the style indices of all contexts of the language.
+     * Returns the default styles the indices refer to.
+     */
+    static QStringList resolveStyles(const QSharedPointer<LanguageContext> &lang,
+                                     const QHash<QString, QString> &styleMap);
+
+    Result highlightLine(const QString &text, int previousState, bool firstLine);
+    // Same as highlightLine, but only finds the state the line ends in
+    int lineState(const QString &text, int previousState, bool firstLine);
+    // Another engine for another thread, sharing the program, formats and states
+    QSharedPointer<HighlightEngine> clone() const;
+
+protected:
+    struct Match
+    {
+        QRegularExpressionMatch match;
+        // Index of the matched context, -1 for none
+        int context;
+        int order;
+
+        inline bool operator<(const Match &other);
+    };
+
+    struct CachedMatch
+    {
+        QRegularExpressionMatch match;
+        bool valid = false;
+    };
+
+    void endNthContainer(HighlightStateTable::State &containers, int n, int offset, int length,
+                         const QRegularExpressionMatch &endMatch = QRegularExpressionMatch());
+
+    void startContainer(HighlightStateTable::State &containers, int containerIndex, int offset,
+                        int length,
+                        const QRegularExpressionMatch &startMatch = QRegularExpressionMatch());
+
+    Match findMatch(const QString &text, int offset, int potentialEnd, int contextIndex,
+                    HighlightStateTable::ContainerInfo &currentContainerInfo,
+                    bool rootContext = true);
+
+    Match findCombinedMatch(const QString &text, int offset, int potentialEnd, int contextIndex,
+                            HighlightStateTable::ContainerInfo &currentContainerInfo);
+
+    QRegularExpressionMatch profiledMatch(const QRegularExpression &regex, const QStringRef &text,
+                                          int offset, int contextIndex);
+    // Notes a match which failed on the limits of ContextProgram::limitPattern()
+    void checkLimits(const QRegularExpression &regex, const QRegularExpressionMatch &match);
+    const ContainerMatcher *matcherFor(int container);
+    bool isForbidden(const HighlightStateTable::ContainerInfo &containerInfo, int context);
+    void forbid(HighlightStateTable::ContainerInfo &containerInfo, int context);
+
+    Result skipLine(int previousState);
+    void setFormat(int start, int count, const QTextCharFormat &format);
+
+    QSharedPointer<const ContextProgram> m_program;
+    // Formats of the style indices
+    QVector<QTextCharFormat> m_formats;
+    QSharedPointer<HighlightStateTable> m_states;
+    // Next matches found on the current line, see ContainerMatcher::Cache
+    QHash<const ContainerMatcher *, ContainerMatcher::Cache> m_matchCache;
+    bool m_firstLine;
+    bool m_collectFormats;
+    // A regex has given up on the current line
+    bool m_limitExceeded;
+    Result m_result;
+};
+
+Q_DECLARE_METATYPE(HighlightEngine::Result)
+
+#endif // HIGHLIGHTENGINE_H
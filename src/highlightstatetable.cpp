@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2016-2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "highlightstatetable.h"
+
+HighlightStateTable::HighlightStateTable()
+{
+    reset(-1);
+}
+
+void HighlightStateTable::reset(int mainStyleIndex)
+{
+    const State initial = { { 0, QRegularExpression(), QBitArray(), mainStyleIndex } };
+
+    QMutexLocker locker(&m_mutex);
+    m_states.clear();
+    m_ids.clear();
+    // State 0 is the one before the first line
+    m_states.append(initial);
+    m_ids.insert(initial, 0);
+}
+
+int HighlightStateTable::intern(const State &state)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_ids.constFind(state);
+    if (it != m_ids.constEnd())
+        return it.value();
+
+    int id = m_states.size();
+    m_states.append(state);
+    m_ids.insert(state, id);
+    return id;
+}
+
+HighlightStateTable::State HighlightStateTable::state(int id) const
+{
+    QMutexLocker locker(&m_mutex);
+    // Blocks which were never highlighted have the state -1
+    if (id < 0 || id >= m_states.size())
+        return m_states.first();
+    return m_states.at(id);
+}
+
+int HighlightStateTable::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_states.size();
+}
+
+bool operator==(const HighlightStateTable::ContainerInfo &a,
+                const HighlightStateTable::ContainerInfo &b)
+{
+    // The style index follows from the containers, so it isn't compared
+    return a.container == b.container && a.endRegex == b.endRegex
+        && a.forbiddenContexts == b.forbiddenContexts;
+}
+
+uint qHash(const HighlightStateTable::ContainerInfo &t, uint seed)
+{
+    /* Since ContainerInfo's fields have different types
+     * and their hashes are computed with different algorithms,
+     * we can simply combine them with xor
+     */
+    return qHash(t.container, seed) ^ qHash(t.endRegex, seed) ^ qHash(t.forbiddenContexts, seed);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2016-2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HIGHLIGHTSTATETABLE_H
+#define HIGHLIGHTSTATETABLE_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QVector>
+#include <QRegularExpression>
+
+/* Container stacks which highlighted lines end in, stored once per document.
+ * Blocks keep only the id of their state, so equal states have equal ids.
+ * The table may be shared by engines running in different threads.
+ */
+class HighlightStateTable
+{
+    Q_DISABLE_COPY(HighlightStateTable)
+public:
+    struct ContainerInfo
+    {
+        // Index in the ContextProgram
+        int container;
+        QRegularExpression endRegex;
+        // Once-only includes which have already matched, see ContainerMatcher::onceOnlyBit
+        QBitArray forbiddenContexts;
+        // Style of the container or of the closest styled one below it
+        int styleIndex;
+    };
+
+    // The innermost container comes first
+    typedef QList<ContainerInfo> State;
+
+    HighlightStateTable();
+
+    // Starts over with the main context, which has the given style
+    void reset(int mainStyleIndex);
+    int intern(const State &state);
+    State state(int id) const;
+    int size() const;
+
+private:
+    mutable QMutex m_mutex;
+    QVector<State> m_states;
+    QHash<State, int> m_ids;
+};
+
+bool operator==(const HighlightStateTable::ContainerInfo &a,
+                const HighlightStateTable::ContainerInfo &b);
+uint qHash(const HighlightStateTable::ContainerInfo &t, uint seed = 0);
+
+#endif // HIGHLIGHTSTATETABLE_H
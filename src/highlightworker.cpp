@@ -0,0 +1,230 @@
+/*
+ * Copyright © 2016-2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "highlightworker.h"
+#include <QSemaphore>
+#include "functionrunnable.h"
+
+// Blocks reported at once, small enough to be applied without a visible delay
+static const int BatchSize = 256;
+// Batches reported but not applied yet, more would only pile up in the event queue
+static const int MaxPendingBatches = 4;
+// Lines highlighted by one task of a parallel run
+static const int ChunkSize = 4096;
+// Lines followed above the window between two reported states
+static const int CheckpointInterval = 1000;
+
+HighlightWorker::HighlightWorker(QObject *parent)
+    : QObject(parent)
+    , m_revision(0)
+    , m_batchSlots(MaxPendingBatches)
+{
+    qRegisterMetaType<QVector<HighlightEngine::Result>>();
+}
+
+void HighlightWorker::setRevision(int revision)
+{
+    m_revision.store(revision);
+}
+
+void HighlightWorker::cancel(int revision)
+{
+    setRevision(revision);
+    QMutexLocker locker(&m_running);
+}
+
+void HighlightWorker::batchApplied()
+{
+    m_batchSlots.release();
+}
+
+void HighlightWorker::highlight(const Job &job)
+{
+    QMutexLocker locker(&m_running);
+    if (m_revision.load() != job.revision || !job.engine)
+        return;
+
+    const QVector<QStringRef> lines = job.text.splitRef(QChar::ParagraphSeparator);
+    const int lineCount = job.firstBlock + lines.size();
+    const int windowStart = qBound(job.firstBlock, job.windowStart, lineCount);
+    const int windowEnd = qBound(windowStart, job.windowEnd, lineCount);
+
+    // Lines above the window are only followed far enough to know where it starts
+    int windowState = job.entryState;
+    for (int i = job.firstBlock; i < windowStart; ++i) {
+        if (m_revision.load() != job.revision)
+            return;
+        if (i > job.firstBlock && (i - job.firstBlock) % CheckpointInterval == 0)
+            emit stateReached(job.revision, i, windowState);
+        windowState =
+            job.engine->lineState(lines.at(i - job.firstBlock).toString(), windowState, i == 0);
+    }
+    if (windowStart > job.firstBlock)
+        emit stateReached(job.revision, windowStart, windowState);
+
+    int state = windowState;
+    if (!run(job, lines, windowStart, windowEnd, &state))
+        return;
+    if (windowEnd < lineCount)
+        emit stateReached(job.revision, windowEnd, state);
+    if (job.windowOnly)
+        return;
+    int aboveState = job.entryState;
+    if (!runParallel(job, lines, job.firstBlock, windowStart, &aboveState))
+        return;
+    runParallel(job, lines, windowEnd, lineCount, &state);
+}
+
+bool HighlightWorker::report(const Job &job, int firstBlock,
+                             const QVector<HighlightEngine::Result> &results)
+{
+    // Wait for the GUI thread to catch up, unless the job is given up meanwhile
+    while (!m_batchSlots.tryAcquire(1, 10)) {
+        if (m_revision.load() != job.revision)
+            return false;
+    }
+    emit highlighted(job.revision, firstBlock, results);
+    return true;
+}
+
+bool HighlightWorker::run(const Job &job, const QVector<QStringRef> &lines, int from, int to,
+                          int *state)
+{
+    QVector<HighlightEngine::Result> results;
+    results.reserve(BatchSize);
+    int batchStart = from;
+    for (int i = from; i < to; ++i) {
+        if (m_revision.load() != job.revision)
+            return false;
+
+        HighlightEngine::Result result =
+            job.engine->highlightLine(lines.at(i - job.firstBlock).toString(), *state, i == 0);
+        *state = result.state;
+        results.append(result);
+
+        if (results.size() == BatchSize || i == to - 1) {
+            if (!report(job, batchStart, results))
+                return false;
+            batchStart = i + 1;
+            results.clear();
+            results.reserve(BatchSize);
+        }
+    }
+    return true;
+}
+
+/* Chunks are highlighted at once, each from the state of a fresh first line,
+ * as most lines of most files are outside of any container. Once the chunk
+ * before is done, the real entry state is known. If it differs, lines are
+ * highlighted again until they end in the same state as the guess did,
+ * the rest of the chunk is right from there on.
+ */
+bool HighlightWorker::runParallel(const Job &job, const QVector<QStringRef> &lines, int from,
+                                  int to, int *state)
+{
+    const int threads = m_pool.maxThreadCount();
+    if (threads < 2 || to - from < 2 * ChunkSize)
+        return run(job, lines, from, to, state);
+
+    struct Chunk
+    {
+        int from;
+        int to;
+        QVector<HighlightEngine::Result> results;
+        QSemaphore done;
+    };
+
+    const int chunkCount = (to - from + ChunkSize - 1) / ChunkSize;
+    QVector<QSharedPointer<Chunk>> chunks;
+    chunks.reserve(chunkCount);
+    for (int i = 0; i < chunkCount; ++i) {
+        auto chunk = QSharedPointer<Chunk>::create();
+        chunk->from = from + i * ChunkSize;
+        chunk->to = qMin(chunk->from + ChunkSize, to);
+        chunks.append(chunk);
+    }
+
+    auto start = [this, &job, &lines](const QSharedPointer<Chunk> &chunk) {
+        QSharedPointer<HighlightEngine> engine = job.engine->clone();
+        m_pool.start(new FunctionRunnable([this, &job, &lines, chunk, engine]() {
+            chunk->results.reserve(chunk->to - chunk->from);
+            int chunkState = -1;
+            for (int i = chunk->from; i < chunk->to; ++i) {
+                if (m_revision.load() != job.revision)
+                    break;
+                HighlightEngine::Result result =
+                    engine->highlightLine(lines.at(i - job.firstBlock).toString(), chunkState,
+                                          i == 0);
+                chunkState = result.state;
+                chunk->results.append(result);
+            }
+            chunk->done.release();
+        }));
+    };
+
+    // Results wait for the chunks before them, so only a few chunks run ahead
+    const int ahead = 2 * threads;
+    int started = 0;
+    for (; started < qMin(ahead, chunkCount); ++started)
+        start(chunks.at(started));
+
+    bool completed = true;
+    for (int i = 0; i < chunkCount && completed; ++i) {
+        Chunk &chunk = *chunks.at(i);
+        chunk.done.acquire();
+        if (started < chunkCount)
+            start(chunks.at(started++));
+        if (m_revision.load() != job.revision
+            || chunk.results.size() != chunk.to - chunk.from) {
+            completed = false;
+            break;
+        }
+
+        // Chunks were started from the state of a fresh first line, which is state 0
+        int realState = *state;
+        // The chunk is wrong up to where it ends up in the same state
+        if (realState > 0) {
+            for (int line = chunk.from; line < chunk.to; ++line) {
+                if (m_revision.load() != job.revision) {
+                    completed = false;
+                    break;
+                }
+                HighlightEngine::Result result = job.engine->highlightLine(
+                    lines.at(line - job.firstBlock).toString(), realState, line == 0);
+                realState = result.state;
+                HighlightEngine::Result &guess = chunk.results[line - chunk.from];
+                const bool converged = result.state == guess.state;
+                guess = result;
+                if (converged)
+                    break;
+            }
+            if (!completed)
+                break;
+        }
+        *state = chunk.results.constLast().state;
+
+        for (int batch = 0; batch < chunk.results.size() && completed; batch += BatchSize)
+            completed = report(job, chunk.from + batch, chunk.results.mid(batch, BatchSize));
+        chunk.results.clear();
+    }
+
+    // The tasks refer to the job and the lines
+    m_pool.waitForDone();
+    return completed;
+}
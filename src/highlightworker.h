@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2016-2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HIGHLIGHTWORKER_H
+#define HIGHLIGHTWORKER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVector>
+#include "highlightengine.h"
+
+/* Highlights a snapshot of the document in its own thread.
+ * Results are reported in batches tagged with the revision of the snapshot,
+ * runs of older revisions stop as soon as a newer revision is set. Only a few
+ * batches may wait to be applied at a time, the worker waits for the rest.
+ * The window (usually the visible blocks) is highlighted before the rest.
+ * States of blocks the worker only follows are reported as checkpoints,
+ * so later jobs can start from them instead of the top of the document.
+ * Long runs are split into chunks highlighted in parallel, see runParallel().
+ */
+class HighlightWorker : public QObject
+{
+    Q_OBJECT
+public:
+    struct Job
+    {
+        QSharedPointer<HighlightEngine> engine;
+        int revision;
+        int firstBlock;
+        int entryState;
+        int windowStart;
+        int windowEnd;
+        // Leave the blocks outside of the window pending
+        bool windowOnly;
+        /* Raw text from firstBlock on, blocks are separated by QChar::ParagraphSeparator.
+         * Lines after it are left alone, so window-only jobs need not go past the window.
+         */
+        QString text;
+    };
+
+    explicit HighlightWorker(QObject *parent = nullptr);
+
+    // Thread-safe
+    void setRevision(int revision);
+    // Thread-safe, returns once no job of an older revision is running
+    void cancel(int revision);
+    // Thread-safe, has to be called for every batch reported, whatever its revision
+    void batchApplied();
+
+    void highlight(const Job &job);
+
+signals:
+    void highlighted(int revision, int firstBlock, const QVector<HighlightEngine::Result> &results);
+    // The line before the block ends in the state
+    void stateReached(int revision, int block, int state);
+
+private:
+    bool report(const Job &job, int firstBlock, const QVector<HighlightEngine::Result> &results);
+    bool run(const Job &job, const QVector<QStringRef> &lines, int from, int to, int *state);
+    bool runParallel(const Job &job, const QVector<QStringRef> &lines, int from, int to,
+                     int *state);
+
+    QAtomicInt m_revision;
+    QMutex m_running;
+    QSemaphore m_batchSlots;
+    QThreadPool m_pool;
+};
+
+#endif // HIGHLIGHTWORKER_H
@@ -0,0 +1,204 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "htmlexporter.h"
+#include <QAtomicInt>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMimeDatabase>
+#include <QTextCodec>
+#include <QThreadPool>
+#include "functionrunnable.h"
+#include "highlightengine.h"
+#include "highlightstatetable.h"
+#include "languagecache.h"
+#include "languagemanager.h"
+
+HtmlExporter::HtmlExporter(QSharedPointer<LanguageDefaultStyles> defaultStyles)
+    : m_defaultStyles(defaultStyles)
+{
+}
+
+int HtmlExporter::exportFiles(const QStringList &files, int jobs)
+{
+    QVector<QSharedPointer<const Language>> languages;
+    languages.reserve(files.size());
+    for (const QString &file : files)
+        languages.append(languageFor(file));
+
+    QThreadPool pool;
+    if (jobs > 0)
+        pool.setMaxThreadCount(jobs);
+    QAtomicInt failures;
+    // Input file by output path, a later file of the same output would overwrite it
+    QHash<QString, QString> outputs;
+    for (int i = 0; i < files.size(); ++i) {
+        const QString file = files.at(i);
+        const QString output = outputPath(file);
+        const QString absoluteOutput = QFileInfo(output).absoluteFilePath();
+        auto previous = outputs.constFind(absoluteOutput);
+        if (previous != outputs.constEnd()) {
+            qWarning().noquote() << file << "would overwrite the export of" << previous.value()
+                                 << "in" << output;
+            failures.ref();
+            continue;
+        }
+        outputs.insert(absoluteOutput, file);
+
+        const QSharedPointer<const Language> language = languages.at(i);
+        pool.start(new FunctionRunnable([this, file, output, language, &failures]() {
+            if (!exportFile(file, output, language))
+                failures.ref();
+        }));
+    }
+    pool.waitForDone();
+    return failures.load();
+}
+
+QSharedPointer<const HtmlExporter::Language> HtmlExporter::languageFor(const QString &file)
+{
+    const QMimeType mimeType = QMimeDatabase().mimeTypeForFile(file);
+    const QString specPath =
+        LanguageManager::getInstance()->pathForMimeType(mimeType, QFileInfo(file).fileName());
+    if (specPath.isEmpty())
+        return QSharedPointer<const Language>();
+
+    auto it = m_languages.constFind(specPath);
+    if (it != m_languages.constEnd())
+        return it.value();
+
+    QSharedPointer<Language> language;
+    auto compiled = LanguageCache::getInstance()->languageForPath(specPath);
+    if (compiled) {
+        language = QSharedPointer<Language>::create();
+        language->program = compiled->program;
+        for (const QString &style : compiled->styles)
+            language->formats.append(m_defaultStyles->styles.value(style));
+    }
+    m_languages.insert(specPath, language);
+    return language;
+}
+
+QString HtmlExporter::outputPath(const QString &file) const
+{
+    const QString name = QFileInfo(file).fileName() + QLatin1String(".html");
+    return m_outputDirectory.isEmpty() ? file + QLatin1String(".html")
+                                       : QDir(m_outputDirectory).filePath(name);
+}
+
+bool HtmlExporter::exportFile(const QString &file, const QString &outputPath,
+                              const QSharedPointer<const Language> &language) const
+{
+    QFile input(file);
+    if (!input.open(QFile::ReadOnly)) {
+        qWarning().noquote() << file << input.errorString();
+        return false;
+    }
+    const QByteArray data = input.readAll();
+    QTextCodec *codec = QTextCodec::codecForUtfText(data, QTextCodec::codecForLocale());
+    const QStringList lines = codec->toUnicode(data).split(QLatin1Char('\n'));
+
+    // Each file gets its own engine, the program is shared
+    QSharedPointer<HighlightEngine> engine;
+    if (language) {
+        auto states = QSharedPointer<HighlightStateTable>::create();
+        states->reset(language->program->context(0).styleIndex);
+        engine = QSharedPointer<HighlightEngine>::create(language->program, language->formats,
+                                                         states);
+    }
+
+    QString html = QStringLiteral("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n"
+                                  "<title>%1</title>\n</head>\n<body>\n<pre>")
+                       .arg(QFileInfo(file).fileName().toHtmlEscaped());
+    int state = -1;
+    QVector<const QTextCharFormat *> charFormats;
+    for (int i = 0; i < lines.size(); ++i) {
+        QString line = lines.at(i);
+        if (line.endsWith(QLatin1Char('\r')))
+            line.chop(1);
+        if (i > 0)
+            html += QLatin1Char('\n');
+        if (!engine) {
+            html += line.toHtmlEscaped();
+            continue;
+        }
+
+        const HighlightEngine::Result result = engine->highlightLine(line, state, i == 0);
+        state = result.state;
+
+        // Later ranges take over the characters of earlier ones, as with QSyntaxHighlighter
+        charFormats.fill(nullptr, line.length());
+        for (const QTextLayout::FormatRange &range : result.formats) {
+            const int end = qMin(range.start + range.length, line.length());
+            for (int c = qMax(range.start, 0); c < end; ++c)
+                charFormats[c] = &range.format;
+        }
+
+        for (int start = 0; start < line.length();) {
+            int end = start + 1;
+            while (end < line.length() && charFormats.at(end) == charFormats.at(start))
+                ++end;
+            const QString text = line.mid(start, end - start).toHtmlEscaped();
+            const QString css = charFormats.at(start) ? style(*charFormats.at(start)) : QString();
+            if (css.isEmpty())
+                html += text;
+            else
+                html += QStringLiteral("<span style=\"%1\">%2</span>").arg(css, text);
+            start = end;
+        }
+    }
+    html += QLatin1String("</pre>\n</body>\n</html>\n");
+
+    QFile output(outputPath);
+    if (!output.open(QFile::WriteOnly | QFile::Truncate) || output.write(html.toUtf8()) < 0) {
+        qWarning().noquote() << outputPath << output.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString HtmlExporter::style(const QTextCharFormat &format)
+{
+    QStringList css;
+    if (format.hasProperty(QTextFormat::ForegroundBrush))
+        css += QStringLiteral("color:%1").arg(format.foreground().color().name());
+    if (format.hasProperty(QTextFormat::BackgroundBrush))
+        css += QStringLiteral("background-color:%1").arg(format.background().color().name());
+    if (format.hasProperty(QTextFormat::FontWeight)) {
+        // QFont weights go from 0 to 99 with Normal at 50, CSS ones from 100 to 900
+        const int weight = format.fontWeight();
+        const int cssWeight =
+            weight <= QFont::Normal ? 100 + weight * 6 : 400 + (weight - QFont::Normal) * 12;
+        css += QStringLiteral("font-weight:%1")
+                   .arg(qBound(100, qRound(cssWeight / 100.0) * 100, 900));
+    }
+    if (format.fontItalic())
+        css += QStringLiteral("font-style:italic");
+    if (format.fontUnderline() || format.fontStrikeOut()) {
+        QStringList lines;
+        if (format.fontUnderline())
+            lines += QStringLiteral("underline");
+        if (format.fontStrikeOut())
+            lines += QStringLiteral("line-through");
+        css += QStringLiteral("text-decoration:") + lines.join(QLatin1Char(' '));
+    }
+    return css.join(QLatin1Char(';'));
+}
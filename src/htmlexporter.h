@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HTMLEXPORTER_H
+#define HTMLEXPORTER_H
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+#include <QTextCharFormat>
+#include "contextprogram.h"
+#include "languagedefaultstyles.h"
+
+/* Writes highlighted copies of files as HTML without any UI.
+ * Languages are loaded in the calling thread first, then the files are
+ * highlighted on a thread pool sharing the compiled languages.
+ */
+class HtmlExporter
+{
+    Q_DISABLE_COPY(HtmlExporter)
+public:
+    explicit HtmlExporter(QSharedPointer<LanguageDefaultStyles> defaultStyles);
+
+    /* Empty for next to the files, as <file>.html. Files of the same name would
+     * overwrite each other there, only the first of them is exported.
+     */
+    inline void setOutputDirectory(const QString &path) { m_outputDirectory = path; }
+    // Returns the number of files that couldn't be exported
+    int exportFiles(const QStringList &files, int jobs);
+
+private:
+    struct Language
+    {
+        QSharedPointer<const ContextProgram> program;
+        QVector<QTextCharFormat> formats;
+    };
+
+    QSharedPointer<const Language> languageFor(const QString &file);
+    QString outputPath(const QString &file) const;
+    bool exportFile(const QString &file, const QString &outputPath,
+                    const QSharedPointer<const Language> &language) const;
+    static QString style(const QTextCharFormat &format);
+
+    QSharedPointer<LanguageDefaultStyles> m_defaultStyles;
+    QString m_outputDirectory;
+    // By spec path, null for files without a language
+    QHash<QString, QSharedPointer<const Language>> m_languages;
+};
+
+#endif // HTMLEXPORTER_H
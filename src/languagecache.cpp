@@ -0,0 +1,245 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "languagecache.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <limits>
+#include "highlightengine.h"
+#include "languageloader.h"
+#include "languagemanager.h"
+#include "precompiledlanguages.h"
+
+// Sizes of compiled languages, enabled with QT_LOGGING_RULES="liri.text.languagecache.debug=true"
+Q_LOGGING_CATEGORY(lcLanguageCache, "liri.text.languagecache", QtInfoMsg)
+
+// Start of every cache file
+static const quint32 CacheFileMagic = 0x4c54434c;
+// Has to change along with the layout of cache files, ContextProgram::save() included
+static const quint32 CacheFileVersion = 2;
+/* Has to change along with anything that changes what a spec compiles to with the same
+ * layout: LanguageLoader, style resolution and the building of ContextProgram.
+ * Cache files of older compilers are compiled again.
+ */
+static const quint32 CompilerRevision = 3;
+
+LanguageCache *LanguageCache::m_instance = nullptr;
+
+LanguageCache::LanguageCache()
+    // Only the ids of the default styles matter for resolving the styles of a language
+    : m_defaultStyles(QSharedPointer<LanguageDefaultStyles>::create())
+{
+    // Next to languages.db
+    QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    m_cacheDirectory = dataDir.filePath(QStringLiteral("language-cache"));
+
+    // Where the language database finds the bundled specs
+#ifdef ABSOLUTE_LANGUAGE_PATH
+    m_bundledDirectories.append(QDir::cleanPath(QStringLiteral(ABSOLUTE_LANGUAGE_PATH)));
+#endif
+#ifdef RELATIVE_LANGUAGE_PATH
+    m_bundledDirectories.append(QDir::cleanPath(QCoreApplication::applicationDirPath()
+                                                + QStringLiteral(RELATIVE_LANGUAGE_PATH)));
+#endif
+}
+
+LanguageCache *LanguageCache::getInstance()
+{
+    static QMutex instanceMutex;
+    QMutexLocker locker(&instanceMutex);
+    if (!m_instance)
+        m_instance = new LanguageCache;
+    return m_instance;
+}
+
+QSharedPointer<const CompiledLanguage> LanguageCache::languageForPath(const QString &specPath)
+{
+    if (specPath.isEmpty())
+        return QSharedPointer<const CompiledLanguage>();
+
+    // Loads are one at a time, so a language asked for twice meanwhile is compiled once
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(specPath);
+    if (it != m_entries.constEnd() && isUpToDate(it.value()))
+        return it.value().language;
+
+    // Documents still using an outdated language keep their copy
+    Entry entry = read(specPath);
+    if (!entry.language) {
+        entry = compile(specPath);
+        if (entry.language)
+            write(specPath, entry);
+    }
+    m_entries.insert(specPath, entry);
+    return entry.language;
+}
+
+QSharedPointer<const CompiledLanguage> LanguageCache::languageForMimeType(const QMimeType &mimeType,
+                                                                          const QString &filename)
+{
+    return languageForPath(LanguageManager::getInstance()->pathForMimeType(mimeType, filename));
+}
+
+LanguageCache::Entry LanguageCache::compile(const QString &specPath) const
+{
+    Entry entry;
+    LanguageLoader loader(m_defaultStyles);
+    auto mainContext = loader.loadMainContext(specPath);
+    for (const QString &file : loader.loadedFiles())
+        entry.files.insert(file, QFileInfo(file).lastModified());
+    if (!mainContext)
+        return entry;
+
+    auto language = QSharedPointer<CompiledLanguage>::create();
+    language->styles = HighlightEngine::resolveStyles(mainContext, loader.styleMap());
+    auto program = QSharedPointer<ContextProgram>::create(mainContext);
+    const LanguageLoader::Statistics statistics = loader.statistics();
+    qCDebug(lcLanguageCache).noquote()
+        << "Loaded" << program->name(0) << "with" << program->nodeCount()
+        << "context nodes merged into" << program->size() << "and" << statistics.regexes
+        << "regexes into" << statistics.uniqueRegexes;
+    // Compile all regexes now instead of while scrolling through the text
+    program->warmUp();
+    language->program = program;
+    // The program keeps what it needs, the context graph isn't used anymore
+    mainContext->base->prepareForRemoval(true);
+
+    entry.language = language;
+    return entry;
+}
+
+LanguageCache::Entry LanguageCache::read(const QString &specPath) const
+{
+    // Bundled specs are installed along with the binary, so they can't have changed
+    const QFileInfo spec(specPath);
+    if (m_bundledDirectories.contains(QDir::cleanPath(spec.absolutePath()))) {
+        const QByteArray data = precompiledLanguage(spec.fileName());
+        if (!data.isEmpty())
+            return deserialize(data, specPath, true);
+    }
+
+    QFile file(cacheFilePath(specPath));
+    if (!file.open(QFile::ReadOnly) || file.size() > std::numeric_limits<int>::max())
+        return Entry();
+    // Mapped rather than read into memory, the program is copied out of it right away
+    const uchar *data = file.map(0, file.size());
+    if (!data)
+        return Entry();
+    return deserialize(
+        QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(file.size())),
+        specPath, false);
+}
+
+void LanguageCache::write(const QString &specPath, const Entry &entry) const
+{
+    if (!QDir().mkpath(m_cacheDirectory))
+        return;
+
+    // Readers never see a partly written file
+    QSaveFile file(cacheFilePath(specPath));
+    if (!file.open(QFile::WriteOnly) || file.write(serialize(specPath, entry)) < 0
+        || !file.commit())
+        qWarning().noquote() << file.fileName() << file.errorString();
+}
+
+QByteArray LanguageCache::compiledData(const QString &specPath)
+{
+    Entry entry = compile(specPath);
+    if (!entry.language)
+        return QByteArray();
+    entry.files.clear();
+    return serialize(QString(), entry);
+}
+
+QByteArray LanguageCache::serialize(const QString &specPath, const Entry &entry)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_10);
+    stream << CacheFileMagic << CacheFileVersion << CompilerRevision << specPath << entry.files
+           << entry.language->styles;
+    entry.language->program->save(stream);
+    return data;
+}
+
+LanguageCache::Entry LanguageCache::deserialize(const QByteArray &data, const QString &specPath,
+                                                bool bundled) const
+{
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_10);
+
+    quint32 magic, version, revision;
+    stream >> magic >> version >> revision;
+    if (stream.status() != QDataStream::Ok || magic != CacheFileMagic
+        || version != CacheFileVersion || revision != CompilerRevision)
+        return Entry();
+
+    Entry entry;
+    QString path;
+    QStringList styles;
+    stream >> path >> entry.files >> styles;
+    if (stream.status() != QDataStream::Ok)
+        return Entry();
+    if (bundled) {
+        // Paths are those of the source tree the language was compiled in
+        entry.files.clear();
+    } else if (path != specPath || !isUpToDate(entry)) {
+        // Specs which have changed since are loaded again and overwrite the file
+        return Entry();
+    }
+
+    auto program = ContextProgram::load(stream, styles.size());
+    if (!program) {
+        qWarning().noquote() << "Ignoring damaged compiled language of" << specPath;
+        return Entry();
+    }
+    // Only the patterns are stored, so the regexes are compiled anew
+    program->warmUp();
+
+    auto language = QSharedPointer<CompiledLanguage>::create();
+    language->program = program;
+    language->styles = styles;
+    entry.language = language;
+    return entry;
+}
+
+QString LanguageCache::cacheFilePath(const QString &specPath) const
+{
+    const QByteArray hash = QCryptographicHash::hash(specPath.toUtf8(), QCryptographicHash::Sha1);
+    return QDir(m_cacheDirectory)
+        .filePath(QString::fromLatin1(hash.toHex()) + QStringLiteral(".bin"));
+}
+
+bool LanguageCache::isUpToDate(const Entry &entry)
+{
+    for (auto it = entry.files.constBegin(), end = entry.files.constEnd(); it != end; ++it) {
+        if (QFileInfo(it.key()).lastModified() != it.value())
+            return false;
+    }
+    return true;
+}
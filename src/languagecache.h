@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LANGUAGECACHE_H
+#define LANGUAGECACHE_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QMimeType>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QStringList>
+#include "contextprogram.h"
+#include "languagedefaultstyles.h"
+
+// A language ready for highlighting, never changed once compiled
+struct CompiledLanguage
+{
+    QSharedPointer<const ContextProgram> program;
+    // Default styles of the style indices of the program
+    QStringList styles;
+};
+
+/* Compiled languages shared by all documents of the process, by spec path.
+ * An entry is compiled again once any of the specs it was loaded from,
+ * dependencies included, has changed on disk. Compiled languages are also
+ * kept in a binary cache next to the language database, so that the specs
+ * only have to be parsed once, and the bundled ones may be compiled into
+ * the binary at build time, see liri-text-langc. Languages may be looked up
+ * and used from any thread.
+ */
+class LanguageCache
+{
+    Q_DISABLE_COPY(LanguageCache)
+public:
+    static LanguageCache *getInstance();
+
+    // Null if the spec can't be loaded
+    QSharedPointer<const CompiledLanguage> languageForPath(const QString &specPath);
+    QSharedPointer<const CompiledLanguage> languageForMimeType(const QMimeType &mimeType,
+                                                               const QString &filename);
+    /* The language as stored in the cache, empty if the spec can't be loaded.
+     * Always compiled anew and leaving out the paths of the specs, for liri-text-langc.
+     */
+    QByteArray compiledData(const QString &specPath);
+
+private:
+    struct Entry
+    {
+        QSharedPointer<const CompiledLanguage> language;
+        // Specs the language was loaded from, with their modification times
+        QHash<QString, QDateTime> files;
+    };
+
+    LanguageCache();
+    Entry compile(const QString &specPath) const;
+    Entry read(const QString &specPath) const;
+    void write(const QString &specPath, const Entry &entry) const;
+    static QByteArray serialize(const QString &specPath, const Entry &entry);
+    // Bundled languages may have been compiled elsewhere, so their specs aren't checked
+    Entry deserialize(const QByteArray &data, const QString &specPath, bool bundled) const;
+    QString cacheFilePath(const QString &specPath) const;
+    static bool isUpToDate(const Entry &entry);
+
+    static LanguageCache *m_instance;
+    QString m_cacheDirectory;
+    // Specs in there are precompiled into the binary, if built so
+    QStringList m_bundledDirectories;
+    QSharedPointer<LanguageDefaultStyles> m_defaultStyles;
+    QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+};
+
+#endif // LANGUAGECACHE_H
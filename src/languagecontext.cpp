@@ -27,6 +27,7 @@
 
 LanguageContext::LanguageContext()
     : type(Undefined)
+    , styleIndex(-1)
 {
 }
 
@@ -35,7 +36,9 @@ LanguageContext::LanguageContext(const LanguageContext &other)
 {
 
     type = other.type;
+    id = other.id;
     styleId = other.styleId;
+    styleIndex = other.styleIndex;
     base = other.base;
 }
 
@@ -90,7 +93,9 @@ void LanguageContext::init(ElementType t, const QXmlStreamAttributes &attributes
 LanguageContext &LanguageContext::operator=(const LanguageContext &other)
 {
     type = other.type;
+    id = other.id;
     styleId = other.styleId;
+    styleIndex = other.styleIndex;
     base = other.base;
     return *this;
 }
@@ -40,7 +40,11 @@ public:
     void init(ElementType t, const QXmlStreamAttributes &attributes);
     LanguageContext &operator=(const LanguageContext &other);
 
+    // Id in the spec, such as c:string, empty for anonymous contexts
+    QString id;
     QString styleId;
+    // Index of the style in the highlighter's format table, -1 if unstyled
+    int styleIndex;
 };
 
 #endif // LANGUAGECONTEXT_H
@@ -37,3 +37,13 @@ LanguageContextKeyword::LanguageContextKeyword(const QXmlStreamAttributes &attri
     if (attributes.hasAttribute(QStringLiteral("once-only")))
         onceOnly = attributes.value(QStringLiteral("once-only")) == "true";
 }
+
+QRegularExpressionMatch LanguageContextKeyword::matchWord(const QStringRef &text, int offset,
+                                                          int *position) const
+{
+    const int *found = nullptr;
+    QRegularExpressionMatch match = findWord(wordRegex, words, caseInsensitiveWords, text, offset,
+                                             [](int value) { return value; }, &found);
+    *position = found ? *found : -1;
+    return match;
+}
@@ -22,6 +22,7 @@
 
 #include <QString>
 #include <QList>
+#include <QHash>
 #include <QRegularExpression>
 #include "languagecontextbase.h"
 
@@ -33,7 +34,32 @@ public:
     LanguageContextKeyword();
     LanguageContextKeyword(const QXmlStreamAttributes &attributes);
 
+    // Keywords which need a regex, with their positions among all keywords of the context
     QList<QRegularExpression> keywords;
+    QList<int> keywordPositions;
+
+    // Plain words, looked up for every word found by wordRegex
+    QHash<QString, int> words;
+    QHash<QString, int> caseInsensitiveWords;
+    QRegularExpression wordRegex;
+
+    inline int keywordCount() const
+    {
+        return keywords.size() + words.size() + caseInsensitiveWords.size();
+    }
+    QRegularExpressionMatch matchWord(const QStringRef &text, int offset, int *position) const;
+
+    /* Scans text for the first word found by regex that is in one of the tables.
+     * A word in both tables takes the entry with the lower order. The entry found
+     * is returned through value, or nullptr if there is none. A scan which fails
+     * on the limits of the regex returns its invalid match.
+     */
+    template <typename T, typename Order>
+    static QRegularExpressionMatch findWord(const QRegularExpression &regex,
+                                            const QHash<QString, T> &words,
+                                            const QHash<QString, T> &caseInsensitiveWords,
+                                            const QStringRef &text, int offset, Order order,
+                                            const T **value);
 
     bool extendParent = true;
     bool endParent = false;
@@ -41,4 +67,35 @@ public:
     bool onceOnly = false;
 };
 
+template <typename T, typename Order>
+QRegularExpressionMatch LanguageContextKeyword::findWord(
+        const QRegularExpression &regex, const QHash<QString, T> &words,
+        const QHash<QString, T> &caseInsensitiveWords, const QStringRef &text, int offset,
+        Order order, const T **value)
+{
+    *value = nullptr;
+    if (words.isEmpty() && caseInsensitiveWords.isEmpty())
+        return QRegularExpressionMatch();
+
+    for (;;) {
+        QRegularExpressionMatch match = regex.match(text, offset);
+        // An invalid regex never matches, unlike one over its limits
+        if (!match.hasMatch())
+            return regex.isValid() ? match : QRegularExpressionMatch();
+        const QString word = match.captured();
+        auto found = words.constFind(word);
+        if (found != words.constEnd())
+            *value = &found.value();
+        if (!caseInsensitiveWords.isEmpty()) {
+            found = caseInsensitiveWords.constFind(word.toCaseFolded());
+            if (found != caseInsensitiveWords.constEnd()
+                && (!*value || order(found.value()) < order(**value)))
+                *value = &found.value();
+        }
+        if (*value)
+            return match;
+        offset = qMax(match.capturedEnd(), offset + 1);
+    }
+}
+
 #endif // LANGUAGECONTEXTKEYWORD_H
@@ -29,11 +29,16 @@
 #include <QDebug>
 #include "languageloader.h"
 
-LanguageDatabaseMaintainer::LanguageDatabaseMaintainer(const QString &path, QObject *parent)
+LanguageDatabaseMaintainer::LanguageDatabaseMaintainer(const QString &path,
+                                                       const QStringList &directories,
+                                                       QObject *parent)
     : QObject(parent)
+    , specsDirs(directories)
     , m_connId(QStringLiteral("lang_db_maintainer"))
     , m_dbPath(path)
 {
+    if (!directories.isEmpty())
+        return;
 
     // List of language specification directories, ascending by priority
 #ifdef GTKSOURCEVIEW_LANGUAGE_PATH
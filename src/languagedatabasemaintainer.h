@@ -30,7 +30,10 @@ class LanguageDatabaseMaintainer : public QObject
 {
     Q_OBJECT
 public:
-    explicit LanguageDatabaseMaintainer(const QString &path, QObject *parent = nullptr);
+    // Without any specs directories, the installed specs and the user's are searched
+    explicit LanguageDatabaseMaintainer(const QString &path,
+                                        const QStringList &directories = QStringList(),
+                                        QObject *parent = nullptr);
     ~LanguageDatabaseMaintainer();
 
 signals:
@@ -33,7 +33,7 @@ LanguageLoader::LanguageLoader(QSharedPointer<LanguageDefaultStyles> defaultStyl
     for (auto styleId = defaultStyles->styles.keyBegin(), end = defaultStyles->styles.keyEnd();
          styleId != end; ++styleId) {
         m_themeStyles += *styleId;
-        m_styleMap[*styleId] = *styleId;
+        m_styleTargets[*styleId] = *styleId;
     }
 }
 
@@ -63,6 +63,7 @@ QSharedPointer<LanguageContext> LanguageLoader::loadMainContext(const QString &p
 {
     QFile file(path);
     QString langId;
+    m_loadedFiles.append(path);
     if (file.open(QFile::ReadOnly)) {
         QXmlStreamReader xml(&file);
         while (!xml.atEnd()) {
@@ -70,10 +71,12 @@ QSharedPointer<LanguageContext> LanguageLoader::loadMainContext(const QString &p
             if (xml.isStartElement()) {
                 if (xml.name() == "language") {
                     langId = xml.attributes().value(QStringLiteral("id")).toString();
+                    m_loadedLanguages.insert(langId);
                     m_languageDefaultOptions[langId] =
                         QRegularExpression::OptimizeOnFirstUsageOption;
                     m_languageLeftWordBoundary[langId] = QStringLiteral("\\b");
                     m_languageRightWordBoundary[langId] = QStringLiteral("\\b");
+                    m_languageKeywordCharClass[langId] = QStringLiteral("\\w");
                 }
                 if (xml.name() == "styles")
                     parseStyles(xml, langId);
@@ -111,6 +114,8 @@ LanguageMetadata LanguageLoader::loadMetadata(const QString &path)
                         result.name = xml.attributes().value(QStringLiteral("_name")).toString();
                     else
                         result.name = xml.attributes().value(QStringLiteral("name")).toString();
+                    result.hidden = xml.attributes().value(QStringLiteral("hidden"))
+                        == QLatin1String("true");
                 }
                 if (xml.name() == "metadata") {
                     parseMetadata(xml, result);
@@ -125,6 +130,10 @@ LanguageMetadata LanguageLoader::loadMetadata(const QString &path)
 
 void LanguageLoader::loadDefinitionsAndStylesById(const QString &id)
 {
+    // Languages referred to by many contexts or styles are loaded once
+    if (m_loadedLanguages.contains(id))
+        return;
+    m_loadedLanguages.insert(id);
     QString path = LanguageManager::getInstance()->pathForId(id);
     loadDefinitionsAndStyles(path);
 }
@@ -133,6 +142,7 @@ void LanguageLoader::loadDefinitionsAndStyles(const QString &path)
 {
     QString langId;
     QFile file(path);
+    m_loadedFiles.append(path);
     if (file.open(QFile::ReadOnly)) {
         QXmlStreamReader xml(&file);
         while (!xml.atEnd()) {
@@ -140,10 +150,12 @@ void LanguageLoader::loadDefinitionsAndStyles(const QString &path)
             if (xml.isStartElement()) {
                 if (xml.name() == "language") {
                     langId = xml.attributes().value(QStringLiteral("id")).toString();
+                    m_loadedLanguages.insert(langId);
                     m_languageDefaultOptions[langId] =
                         QRegularExpression::OptimizeOnFirstUsageOption;
                     m_languageLeftWordBoundary[langId] = QStringLiteral("\\b");
                     m_languageRightWordBoundary[langId] = QStringLiteral("\\b");
+                    m_languageKeywordCharClass[langId] = QStringLiteral("\\w");
                 }
                 if (xml.name() == "styles")
                     parseStyles(xml, langId);
@@ -220,7 +232,7 @@ LanguageLoader::parseContext(QXmlStreamReader &xml, const QString &langId,
 
     if (contextAttributes.hasAttribute(QStringLiteral("style-ref"))) {
         QString styleId = xml.attributes().value(QStringLiteral("style-ref")).toString();
-        if (styleId.contains(':') && !m_styleMap.contains(styleId))
+        if (styleId.contains(':') && !m_styleTargets.contains(styleId))
             loadDefinitionsAndStylesById(styleId.left(styleId.indexOf(':')));
         if (!styleId.contains(':'))
             styleId = langId + ":" + styleId;
@@ -240,6 +252,7 @@ LanguageLoader::parseContext(QXmlStreamReader &xml, const QString &langId,
     if (contextAttributes.hasAttribute(QStringLiteral("id"))) {
         QString id = langId + ":" + contextAttributes.value(QStringLiteral("id")).toString();
         // Known context could've already been set by replace tag
+        result->context->id = id;
         if (!m_knownContexts.contains(id))
             m_knownContexts[id] = result;
         m_originalContexts[id] = result;
@@ -308,8 +321,13 @@ LanguageLoader::parseContext(QXmlStreamReader &xml, const QString &langId,
                 result->context->init(LanguageContext::Keyword, contextAttributes);
 
             auto options = parseRegexOptions(xml, langId);
-            result->context->base.staticCast<LanguageContextKeyword>()->keywords +=
-                resolveRegex(kwPrefix + xml.readElementText() + kwSuffix, options, langId);
+            auto keywordContext = result->context->base.staticCast<LanguageContextKeyword>();
+            QString keyword = xml.readElementText();
+            if (!addPlainKeyword(keywordContext, keyword, kwPrefix, kwSuffix, options, langId)) {
+                keywordContext->keywordPositions += keywordContext->keywordCount();
+                keywordContext->keywords +=
+                    resolveRegex(kwPrefix + keyword + kwSuffix, options, langId);
+            }
         }
         if (xml.name() == "include") {
             xml.readNext();
@@ -355,27 +373,57 @@ void LanguageLoader::parseStyle(QXmlStreamReader &xml, const QString &langId)
     QString mapId;
     if (!m_themeStyles.contains(id) && xml.attributes().hasAttribute(QStringLiteral("map-to"))) {
         QString refId = xml.attributes().value(QStringLiteral("map-to")).toString();
-        if (refId.contains(':') && !m_styleMap.contains(refId)) {
+        if (refId.contains(':') && !m_styleTargets.contains(refId)) {
             loadDefinitionsAndStylesById(refId.left(refId.indexOf(':')));
         }
         if (!refId.contains(':'))
             refId = langId + ":" + refId;
-        if (m_styleMap.contains(refId))
-            mapId = m_styleMap[refId];
-        else
-            mapId = refId;
+        mapId = refId;
     } else
         mapId = id;
 
-    for (auto key = m_styleMap.keyBegin(), end = m_styleMap.keyEnd(); key != end; ++key) {
-        if (m_styleMap[*key] == id)
-            m_styleMap[*key] = mapId;
-    }
-    m_styleMap[id] = mapId;
+    // Chains of map-to are followed once all styles are known, see styleMap()
+    m_styleTargets[id] = mapId;
+    m_styleMap.clear();
 
     xml.skipCurrentElement();
 }
 
+QHash<QString, QString> LanguageLoader::styleMap()
+{
+    if (m_styleMap.size() != m_styleTargets.size()) {
+        for (auto id = m_styleTargets.keyBegin(), end = m_styleTargets.keyEnd(); id != end; ++id)
+            resolveStyle(*id);
+    }
+    return m_styleMap;
+}
+
+QString LanguageLoader::resolveStyle(const QString &id)
+{
+    // Follows map-to up to a style mapping to itself, then points the whole chain there
+    QStringList chain;
+    QString current = id;
+    for (;;) {
+        auto resolved = m_styleMap.constFind(current);
+        if (resolved != m_styleMap.constEnd()) {
+            current = resolved.value();
+            break;
+        }
+        auto target = m_styleTargets.constFind(current);
+        // Styles mapping to unknown ones end there, a cycle ends anywhere
+        if (target == m_styleTargets.constEnd() || target.value() == current
+            || chain.size() > m_styleTargets.size())
+            break;
+        chain.append(current);
+        current = target.value();
+    }
+    for (const QString &style : qAsConst(chain))
+        m_styleMap.insert(style, current);
+    if (m_styleTargets.contains(current))
+        m_styleMap.insert(current, current);
+    return current;
+}
+
 QRegularExpression::PatternOptions LanguageLoader::parseRegexOptions(QXmlStreamReader &xml,
                                                                      const QString &langId)
 {
@@ -411,6 +459,8 @@ void LanguageLoader::parseDefineRegex(QXmlStreamReader &xml, const QString &lang
     QString id = xml.attributes().value(QStringLiteral("id")).toString();
     auto options = parseRegexOptions(xml, langId);
     m_knownRegexes[langId + ":" + id] = applyOptionsToSubRegex(xml.readElementText(), options);
+    // Expansions may refer to a previous definition of it
+    m_expandedRegexes.clear();
 }
 
 void LanguageLoader::parseWordCharClass(QXmlStreamReader &xml, const QString &langId)
@@ -418,6 +468,9 @@ void LanguageLoader::parseWordCharClass(QXmlStreamReader &xml, const QString &la
     QString charClass = xml.readElementText();
     m_languageLeftWordBoundary[langId] = QStringLiteral("(?<!%1)(?=%1)").arg(charClass);
     m_languageRightWordBoundary[langId] = QStringLiteral("(?<=%1)(?!%1)").arg(charClass);
+    m_languageKeywordCharClass[langId] = charClass;
+    // Expansions may contain the previous word boundaries
+    m_expandedRegexes.clear();
 }
 
 void LanguageLoader::parseReplace(QXmlStreamReader &xml, const QString &langId)
@@ -435,22 +488,139 @@ void LanguageLoader::parseReplace(QXmlStreamReader &xml, const QString &langId)
     xml.readNext();
 }
 
+bool LanguageLoader::addPlainKeyword(QSharedPointer<LanguageContextKeyword> context,
+                                     const QString &keyword, const QString &prefix,
+                                     const QString &suffix,
+                                     QRegularExpression::PatternOptions options,
+                                     const QString &langId)
+{
+    /* A keyword surrounded by word boundaries matches exactly when it equals a whole
+     * run of word characters, so plain words can be found with a hash lookup per word
+     * instead of a regex per keyword.
+     */
+    QString charClass;
+    if (prefix == QLatin1String("\\%[") && suffix == QLatin1String("\\%]"))
+        charClass = m_languageKeywordCharClass[langId];
+    else if (prefix == QLatin1String("\\b") && suffix == QLatin1String("\\b"))
+        charClass = QStringLiteral("\\w");
+    else
+        return false;
+
+    const QRegularExpression::PatternOptions plainOptions =
+        QRegularExpression::CaseInsensitiveOption | QRegularExpression::ExtendedPatternSyntaxOption
+        | QRegularExpression::OptimizeOnFirstUsageOption;
+    if ((options & ~plainOptions) != 0 || QRegularExpression::escape(keyword) != keyword)
+        return false;
+
+    const QRegularExpression wordRegex =
+        internRegex(QStringLiteral("(?<!%1)(?:%1)+").arg(charClass), options);
+    const QRegularExpression wholeWord =
+        internRegex(QStringLiteral("\\A(?:%1)+\\z").arg(charClass), options);
+    if (!wholeWord.match(keyword).hasMatch())
+        return false;
+
+    // All plain words of a context are found with the same regex
+    if (context->wordRegex.pattern().isEmpty())
+        context->wordRegex = wordRegex;
+    else if (context->wordRegex != wordRegex)
+        return false;
+
+    const int position = context->keywordCount();
+    if ((options & QRegularExpression::CaseInsensitiveOption) != 0) {
+        if (!context->caseInsensitiveWords.contains(keyword.toCaseFolded()))
+            context->caseInsensitiveWords.insert(keyword.toCaseFolded(), position);
+    } else if (!context->words.contains(keyword)) {
+        context->words.insert(keyword, position);
+    }
+    return true;
+}
+
 QRegularExpression LanguageLoader::resolveRegex(const QString &pattern,
                                                 QRegularExpression::PatternOptions options,
                                                 const QString &langId)
 {
-    QString resultPattern = pattern;
+    return internRegex(expandReferences(pattern, langId), options);
+}
+
+QRegularExpression LanguageLoader::internRegex(const QString &pattern,
+                                               QRegularExpression::PatternOptions options)
+{
+    // Copies share the compiled pattern, so equal regexes are compiled and optimized once
+    ++m_statistics.regexes;
+    const QPair<QString, int> key(pattern, int(options));
+    auto it = m_regexPool.constFind(key);
+    if (it != m_regexPool.constEnd())
+        return it.value();
+    const QRegularExpression regex(pattern, options);
+    m_regexPool.insert(key, regex);
+    m_statistics.uniqueRegexes = m_regexPool.size();
+    return regex;
+}
 
-    for (auto id = m_knownRegexes.keyBegin(), end = m_knownRegexes.keyEnd(); id != end; ++id) {
-        resultPattern.replace("\\%{" + *id + "}", m_knownRegexes[*id]);
-        if (id->startsWith(langId + ":")) {
-            resultPattern.replace("\\%{" + id->right(id->length() - (id->indexOf(':') + 1)) + "}",
-                                  m_knownRegexes[*id]);
+QString LanguageLoader::expandReferences(const QString &pattern, const QString &langId)
+{
+    // A single scan, escaped backslashes are copied so that \\%{id} stays literal
+    QString result;
+    result.reserve(pattern.size());
+    const int length = pattern.length();
+    int i = 0;
+    while (i < length) {
+        const QChar c = pattern.at(i);
+        if (c != QLatin1Char('\\') || i + 1 == length) {
+            result += c;
+            ++i;
+            continue;
+        }
+        if (pattern.at(i + 1) == QLatin1Char('%') && i + 2 < length) {
+            const QChar kind = pattern.at(i + 2);
+            if (kind == QLatin1Char('[')) {
+                result += m_languageLeftWordBoundary.value(langId);
+                i += 3;
+                continue;
+            }
+            if (kind == QLatin1Char(']')) {
+                result += m_languageRightWordBoundary.value(langId);
+                i += 3;
+                continue;
+            }
+            // References to start sub-patterns such as \%{1@start} are no define-regex
+            const int close = kind == QLatin1Char('{') ? pattern.indexOf(QLatin1Char('}'), i + 3) : -1;
+            QString expansion;
+            if (close >= 0
+                && expandDefinedRegex(pattern.mid(i + 3, close - i - 3), langId, &expansion)) {
+                result += expansion;
+                i = close + 1;
+                continue;
+            }
         }
+        result += c;
+        result += pattern.at(i + 1);
+        i += 2;
+    }
+    return result;
+}
+
+bool LanguageLoader::expandDefinedRegex(const QString &id, const QString &langId,
+                                        QString *expansion)
+{
+    const QString fullId = id.contains(':') ? id : langId + ":" + id;
+    auto expanded = m_expandedRegexes.constFind(fullId);
+    if (expanded != m_expandedRegexes.constEnd()) {
+        *expansion = expanded.value();
+        return true;
     }
-    resultPattern.replace(QLatin1String("\\%["), m_languageLeftWordBoundary[langId]);
-    resultPattern.replace(QLatin1String("\\%]"), m_languageRightWordBoundary[langId]);
-    return QRegularExpression(resultPattern, options);
+
+    auto known = m_knownRegexes.constFind(fullId);
+    // Cyclic references are left as they are, like unknown ones
+    if (known == m_knownRegexes.constEnd() || m_expandingRegexes.contains(fullId))
+        return false;
+
+    // References inside a define-regex belong to the language defining it
+    m_expandingRegexes.insert(fullId);
+    *expansion = expandReferences(known.value(), fullId.left(fullId.indexOf(':')));
+    m_expandingRegexes.remove(fullId);
+    m_expandedRegexes.insert(fullId, *expansion);
+    return true;
 }
 
 QString LanguageLoader::escapeNonExtended(const QString &pattern)
@@ -24,9 +24,13 @@
 #include <QXmlStreamReader>
 #include <QRegularExpression>
 #include <QHash>
+#include <QPair>
+#include <QSet>
 #include <QMimeType>
+#include <QStringList>
 
 #include "languagecontextreference.h"
+#include "languagecontextkeyword.h"
 #include "languagedefaultstyles.h"
 #include "languagemetadata.h"
 
@@ -34,6 +38,13 @@ class LanguageLoader
 {
     Q_DISABLE_COPY(LanguageLoader)
 public:
+    struct Statistics
+    {
+        // Regexes the specs asked for, and how many of them differ
+        int regexes = 0;
+        int uniqueRegexes = 0;
+    };
+
     LanguageLoader();
     LanguageLoader(QSharedPointer<LanguageDefaultStyles> defaultStyles);
     ~LanguageLoader();
@@ -46,7 +57,11 @@ public:
     void loadDefinitionsAndStylesById(const QString &id);
     void loadDefinitionsAndStyles(const QString &path);
 
-    inline QHash<QString, QString> styleMap() { return m_styleMap; }
+    // Default style of every style, by full id
+    QHash<QString, QString> styleMap();
+    // Specs read for the contexts loaded so far
+    inline QStringList loadedFiles() const { return m_loadedFiles; }
+    inline Statistics statistics() const { return m_statistics; }
 
 private:
     void parseMetadata(QXmlStreamReader &xml, LanguageMetadata &metadata);
@@ -56,15 +71,24 @@ private:
     parseContext(QXmlStreamReader &xml, const QString &langId,
                  const QXmlStreamAttributes &additionalAttributes = QXmlStreamAttributes());
     void parseStyle(QXmlStreamReader &xml, const QString &langId);
+    QString resolveStyle(const QString &id);
     QRegularExpression::PatternOptions parseRegexOptions(QXmlStreamReader &xml,
                                                          const QString &langId);
     void parseDefaultRegexOptions(QXmlStreamReader &xml, const QString &langId);
     void parseDefineRegex(QXmlStreamReader &xml, const QString &langId);
     void parseWordCharClass(QXmlStreamReader &xml, const QString &langId);
     void parseReplace(QXmlStreamReader &xml, const QString &langId);
+    bool addPlainKeyword(QSharedPointer<LanguageContextKeyword> context, const QString &keyword,
+                         const QString &prefix, const QString &suffix,
+                         QRegularExpression::PatternOptions options, const QString &langId);
     QRegularExpression resolveRegex(const QString &pattern,
                                     QRegularExpression::PatternOptions options,
                                     const QString &langId);
+    QRegularExpression internRegex(const QString &pattern,
+                                   QRegularExpression::PatternOptions options);
+    // Replaces \%{id}, \%[ and \%] references, expanding define-regexes on demand
+    QString expandReferences(const QString &pattern, const QString &langId);
+    bool expandDefinedRegex(const QString &id, const QString &langId, QString *expansion);
     QString escapeNonExtended(const QString &pattern);
     QString applyOptionsToSubRegex(const QString &pattern,
                                    QRegularExpression::PatternOptions options);
@@ -74,11 +98,23 @@ private:
     QHash<QString, QSharedPointer<LanguageContextReference>> m_knownContexts;
     QHash<QString, QSharedPointer<LanguageContextReference>> m_originalContexts;
     QHash<QString, QString> m_knownRegexes;
+    // Define-regexes with all their references replaced, by full id
+    QHash<QString, QString> m_expandedRegexes;
+    QSet<QString> m_expandingRegexes;
     QHash<QString, QRegularExpression::PatternOptions> m_languageDefaultOptions;
     QHash<QString, QString> m_languageLeftWordBoundary;
     QHash<QString, QString> m_languageRightWordBoundary;
+    QHash<QString, QString> m_languageKeywordCharClass;
+    // The map-to of every style, styles which aren't mapped map to themselves
+    QHash<QString, QString> m_styleTargets;
+    // Resolved from m_styleTargets when asked for
     QHash<QString, QString> m_styleMap;
+    QSet<QString> m_loadedLanguages;
+    // Every regex created so far, by pattern and options
+    QHash<QPair<QString, int>, QRegularExpression> m_regexPool;
+    Statistics m_statistics;
     QList<QString> m_themeStyles;
+    QStringList m_loadedFiles;
 };
 
 #endif // LANGUAGELOADER_H
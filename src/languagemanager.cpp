@@ -25,27 +25,48 @@
 #include <QThread>
 #include <QDir>
 #include <QStandardPaths>
+#include <algorithm>
 
 LanguageManager::LanguageManager(QObject *parent)
     : QObject(parent)
     , m_connId(QStringLiteral("languages"))
 {
 
-    QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
-    if (!dataDir.exists())
-        dataDir.mkpath(QStringLiteral("."));
-    QString dbPath = dataDir.filePath(QStringLiteral("languages.db"));
+    m_dbPath = m_defaultDbPath;
+    if (m_dbPath.isEmpty()) {
+        QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+        if (!dataDir.exists())
+            dataDir.mkpath(QStringLiteral("."));
+        m_dbPath = dataDir.filePath(QStringLiteral("languages.db"));
+    }
 
     m_thread = new QThread;
-    LanguageDatabaseMaintainer *dbMaintainer = new LanguageDatabaseMaintainer(dbPath);
+    LanguageDatabaseMaintainer *dbMaintainer =
+        new LanguageDatabaseMaintainer(m_dbPath, m_defaultSpecsDirs);
     dbMaintainer->moveToThread(m_thread);
     connect(m_thread, &QThread::started, dbMaintainer, &LanguageDatabaseMaintainer::init);
     connect(m_thread, &QThread::finished, dbMaintainer, &LanguageDatabaseMaintainer::deleteLater);
+    // The index is up to date before anyone hears of the update
+    connect(dbMaintainer, &LanguageDatabaseMaintainer::dbUpdated, this,
+            &LanguageManager::updateIndex);
     m_thread->start();
 
-    QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), m_connId);
-    db.setDatabaseName(dbPath);
-    db.open();
+    // Languages found by the previous run are there until then
+    buildIndex();
+}
+
+QSqlDatabase LanguageManager::database() const
+{
+    // A connection can only be used by the thread which opened it
+    const QString connId =
+        m_connId + QString::number(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    QSqlDatabase db = QSqlDatabase::database(connId);
+    if (!db.isValid()) {
+        db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connId);
+        db.setDatabaseName(m_dbPath);
+        db.open();
+    }
+    return db;
 }
 
 LanguageManager *LanguageManager::getInstance()
@@ -55,70 +76,150 @@ LanguageManager *LanguageManager::getInstance()
     return m_instance;
 }
 
+void LanguageManager::setDatabasePath(const QString &path)
+{
+    m_defaultDbPath = path;
+}
+
+void LanguageManager::setSpecsDirectories(const QStringList &directories)
+{
+    m_defaultSpecsDirs = directories;
+}
+
+void LanguageManager::updateIndex()
+{
+    buildIndex();
+    emit dbUpdated();
+}
+
+static bool isWildcard(const QChar &c)
+{
+    return c == '*' || c == '?' || c == '[';
+}
+
+static QRegularExpression globToRegexp(QString glob)
+{
+    // Very simple glob-to-regexp translation
+
+    glob.replace('.', QLatin1String("\\."));
+    glob.replace('?', QLatin1String("."));
+    // In glob starting with *. * shouldn't match empty string
+    if (glob.startsWith(QLatin1String("*\\.")))
+        glob.replace(0, 1, QStringLiteral(".+"));
+    // Elsewhere it can
+    glob.replace('*', QLatin1String(".*"));
+
+    QRegularExpression regexp("^" + glob + "$");
+    regexp.optimize();
+    return regexp;
+}
+
+void LanguageManager::buildIndex()
+{
+    QHash<QString, QString> pathsById;
+    QHash<QString, QString> pathsByMimeType;
+    QStringList globPaths;
+    QHash<QString, int> globsByName;
+    QHash<QString, int> globsByExtension;
+    QVector<Glob> globRegexps;
+
+    // Languages in the order lookups used to find them, the spec of highest priority first
+    QSqlQuery query(QStringLiteral("SELECT id, spec_path, mime_types, globs FROM languages "
+                                   "ORDER BY id, priority DESC"),
+                    database());
+    while (query.next()) {
+        const QString id = query.value(0).toString();
+        if (pathsById.contains(id))
+            continue;
+        const QString specPath = query.value(1).toString();
+        pathsById.insert(id, specPath);
+
+        const QStringList mimeTypes =
+            query.value(2).toString().split(';', QString::SkipEmptyParts);
+        for (const QString &mimeType : mimeTypes) {
+            if (!pathsByMimeType.contains(mimeType))
+                pathsByMimeType.insert(mimeType, specPath);
+        }
+
+        const QStringList globs = query.value(3).toString().split(';', QString::SkipEmptyParts);
+        for (const QString &glob : globs) {
+            const int order = globPaths.size();
+            globPaths.append(specPath);
+            const bool startsWithExtension = glob.startsWith(QLatin1String("*."));
+            const QString name = startsWithExtension ? glob.mid(2) : glob;
+            if (std::any_of(name.cbegin(), name.cend(), isWildcard))
+                globRegexps.append({ globToRegexp(glob), order });
+            else if (startsWithExtension && !globsByExtension.contains(name))
+                globsByExtension.insert(name, order);
+            else if (!startsWithExtension && !globsByName.contains(name))
+                globsByName.insert(name, order);
+        }
+    }
+
+    QWriteLocker locker(&m_indexLock);
+    m_pathsById.swap(pathsById);
+    m_pathsByMimeType.swap(pathsByMimeType);
+    m_globPaths.swap(globPaths);
+    m_globsByName.swap(globsByName);
+    m_globsByExtension.swap(globsByExtension);
+    m_globRegexps.swap(globRegexps);
+}
+
 QString LanguageManager::pathForId(const QString &id)
 {
-    QSqlQuery query(QStringLiteral("SELECT spec_path, MAX(priority) FROM languages "
-                                   "WHERE id = '%1' GROUP BY id")
-                        .arg(id),
-                    QSqlDatabase::database(m_connId));
-    if (query.next())
-        return query.value(0).toString();
-    else
-        return QString();
+    QReadLocker locker(&m_indexLock);
+    return m_pathsById.value(id);
 }
 
 QString LanguageManager::pathForMimeType(const QMimeType &mimeType, const QString &filename)
 {
+    QReadLocker locker(&m_indexLock);
+
     // Original name first
-    {
-        QSqlQuery query(QStringLiteral("SELECT spec_path, MAX(priority) FROM languages "
-                                       "WHERE instr(mime_types, '%1') > 0 GROUP BY id")
-                            .arg(mimeType.name()),
-                        QSqlDatabase::database(m_connId));
-        if (query.next())
-            return query.value(0).toString();
-    }
+    auto it = m_pathsByMimeType.constFind(mimeType.name());
+    if (it != m_pathsByMimeType.constEnd())
+        return it.value();
 
     // Aliases and parents second
     // TODO: Check if we actually need to check all ancestors
     const QStringList &alternatives = mimeType.aliases() + mimeType.allAncestors();
     for (const QString &aType : alternatives) {
-        QSqlQuery query(QStringLiteral("SELECT spec_path, MAX(priority) FROM languages "
-                                       "WHERE instr(mime_types, '%1') > 0 GROUP BY id")
-                            .arg(aType),
-                        QSqlDatabase::database(m_connId));
-        if (query.next())
-            return query.value(0).toString();
+        it = m_pathsByMimeType.constFind(aType);
+        if (it != m_pathsByMimeType.constEnd())
+            return it.value();
     }
 
     // MIME type lookup failed
     // Search for glob fitting the filename
-    {
-        QSqlQuery query(
-            QStringLiteral("SELECT globs, spec_path, MAX(priority) FROM languages GROUP BY id"),
-            QSqlDatabase::database(m_connId));
-        while (query.next()) {
-            const QStringList &globs = query.value(0).toString().split(';');
-            for (QString glob : globs) {
-                // Very simple glob-to-regexp translation
-
-                glob.replace('.', QLatin1String("\\."));
-                glob.replace('?', QLatin1String("."));
-                // In glob starting with *. * shouldn't match empty string
-                if (glob.startsWith(QLatin1String("*\\.")))
-                    glob.replace(0, 1, QStringLiteral(".+"));
-                // Elsewhere it can
-                glob.replace('*', QLatin1String(".*"));
-
-                QRegularExpression regexp("^" + glob + "$");
-
-                if (regexp.match(filename, 0).hasMatch())
-                    return query.value(1).toString();
-            }
+    return pathForFileName(filename);
+}
+
+QString LanguageManager::pathForFileName(const QString &filename) const
+{
+    // The first glob fitting the filename wins, wherever it is kept
+    int found = m_globsByName.value(filename, -1);
+    auto consider = [&found](int order) {
+        if (found < 0 || order < found)
+            found = order;
+    };
+
+    // *.ext needs something in front of the dot
+    for (int dot = filename.indexOf('.', 1); dot >= 0; dot = filename.indexOf('.', dot + 1)) {
+        auto it = m_globsByExtension.constFind(filename.mid(dot + 1));
+        if (it != m_globsByExtension.constEnd())
+            consider(it.value());
+    }
+
+    for (const Glob &glob : m_globRegexps) {
+        if (found >= 0 && glob.order > found)
+            break;
+        if (glob.regexp.match(filename).hasMatch()) {
+            consider(glob.order);
+            break;
         }
     }
 
-    return QString();
+    return found < 0 ? QString() : m_globPaths.at(found);
 }
 
 LanguageManager::~LanguageManager()
@@ -129,3 +230,5 @@ LanguageManager::~LanguageManager()
 }
 
 LanguageManager *LanguageManager::m_instance = nullptr;
+QString LanguageManager::m_defaultDbPath;
+QStringList LanguageManager::m_defaultSpecsDirs;
@@ -23,23 +23,69 @@
 #include <QObject>
 #include <QSqlDatabase>
 #include <QMimeType>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QRegularExpression>
+#include <QVector>
 #include "languagedatabasemaintainer.h"
 
 class QThread;
+/* Finds language specs through the language database.
+ * The database is read into an index once it has been updated, so lookups
+ * don't touch SQLite, and they may come from any thread.
+ */
 class LanguageManager : public QObject
 {
     Q_OBJECT
 public:
     static LanguageManager *getInstance();
+    /* For tools which must leave the user's data alone, to be called before getInstance().
+     * By default the database is kept next to the user's data, and the installed specs
+     * are searched along with the user's own.
+     */
+    static void setDatabasePath(const QString &path);
+    static void setSpecsDirectories(const QStringList &directories);
     QString pathForId(const QString &id);
     QString pathForMimeType(const QMimeType &mimeType, const QString &filename);
 
+signals:
+    // The database has been brought up to date with the spec directories
+    void dbUpdated();
+
+private slots:
+    void updateIndex();
+
 private:
+    struct Glob
+    {
+        QRegularExpression regexp;
+        // Position in the order globs are tried in
+        int order;
+    };
+
     explicit LanguageManager(QObject *parent = 0);
     ~LanguageManager();
+    QSqlDatabase database() const;
+    void buildIndex();
+    QString pathForFileName(const QString &filename) const;
     static LanguageManager *m_instance;
+    static QString m_defaultDbPath;
+    static QStringList m_defaultSpecsDirs;
     QThread *m_thread;
     const QString m_connId;
+    QString m_dbPath;
+
+    // Guards the index below
+    mutable QReadWriteLock m_indexLock;
+    QHash<QString, QString> m_pathsById;
+    QHash<QString, QString> m_pathsByMimeType;
+    // Spec paths of all globs, by order
+    QStringList m_globPaths;
+    // Globs without wildcards and those of the form *.ext, by ext
+    QHash<QString, int> m_globsByName;
+    QHash<QString, int> m_globsByExtension;
+    // Any other glob, precompiled
+    QVector<Glob> m_globRegexps;
 };
 
 #endif // LANGUAGEMANAGER_H
@@ -28,6 +28,8 @@ struct LanguageMetadata
     QString name;
     QString mimeTypes;
     QString globs;
+    // Only included by other languages
+    bool hidden = false;
 };
 
 #endif // LANGUAGEMETADATA_H
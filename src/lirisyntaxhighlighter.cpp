@@ -18,51 +18,145 @@
  */
 
 #include <QTextDocument>
-#include <QRegularExpression>
 #include <QTextDocumentFragment>
+#include <QThread>
 #include <QDebug>
 #include "lirisyntaxhighlighter.h"
-#include "languagecontextkeyword.h"
-#include "languagecontextcontainer.h"
-#include "languagecontextsimple.h"
-#include "languagecontextsubpattern.h"
+
+// State of blocks which wait for the worker
+static const int PendingState = -2;
+// Blocks below the visible ones which are highlighted along with them
+static const int LookaheadBlocks = 100;
+// Scrolling restarts the worker at most this often
+static const int ViewportRestartDelay = 100;
+// State of blocks whose highlighting was put off to stay within the time budget
+static const int DeferredState = -3;
+// Milliseconds of highlighting in the GUI thread before returning to the event loop
+static const int SliceBudget = 8;
+
+namespace {
+
+// Marks a block whose line was left unhighlighted, so it is reported only once
+class SkippedLineData : public QTextBlockUserData
+{
+};
+
+} // namespace
 
 LiriSyntaxHighlighter::LiriSyntaxHighlighter(QObject *parent)
     : QSyntaxHighlighter(parent)
-    , m_lang()
+    , m_language()
     , m_defStyles()
 {
+    init();
 }
 
 LiriSyntaxHighlighter::LiriSyntaxHighlighter(QTextDocument *parent)
     : QSyntaxHighlighter(parent)
-    , m_lang()
+    , m_language()
     , m_defStyles()
 {
+    init();
 }
 
 LiriSyntaxHighlighter::~LiriSyntaxHighlighter()
 {
-    if (m_lang)
-        m_lang->base->prepareForRemoval(true);
+    m_worker->cancel(++m_revision);
+    m_workerThread->quit();
+    m_workerThread->wait();
+    delete m_workerThread;
+    dumpRegexProfile();
 }
 
-void LiriSyntaxHighlighter::setLanguage(QSharedPointer<LanguageContext> lang,
-                                        const QHash<QString, QString> &styleMap)
+void LiriSyntaxHighlighter::setLanguage(QSharedPointer<const CompiledLanguage> language)
 {
-    if (m_lang)
-        m_lang->base->prepareForRemoval(true);
-    m_lang = lang;
-    m_styleMap = styleMap;
+    // Results of the previous language are of no use anymore
+    m_worker->cancel(++m_revision);
+    dumpRegexProfile();
+    m_language = language;
+    m_program = m_language ? m_language->program : QSharedPointer<const ContextProgram>();
+    m_states->reset(m_program ? m_program->context(0).styleIndex : -1);
+    m_checkpoints.clear();
+    m_checkpointRevision = m_revision;
+    updateEngines();
     if (m_defStyles)
-        rehighlight();
+        rehighlightInBackground();
 }
 
 void LiriSyntaxHighlighter::setDefaultStyles(QSharedPointer<LanguageDefaultStyles> defStyles)
 {
+    m_worker->cancel(++m_revision);
     m_defStyles = defStyles;
-    if (m_lang)
-        rehighlight();
+    updateEngines();
+    if (m_language)
+        rehighlightInBackground();
+}
+
+void LiriSyntaxHighlighter::rehighlightInBackground()
+{
+    if (!document())
+        return;
+    if (!m_engine) {
+        m_firstPending = QTextCursor();
+        m_deferred.clear();
+        clearFormats();
+        return;
+    }
+
+    /* No block refers to a state anymore, so the table starts over and drops
+     * the states of text edited away since. Results of the worker still refer
+     * to the old ids and are discarded by revision.
+     */
+    m_worker->cancel(++m_revision);
+    m_states->reset(m_program->context(0).styleIndex);
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next())
+        block.setUserState(PendingState);
+    m_firstPending = QTextCursor(document());
+    m_checkpoints.clear();
+    m_checkpointRevision = m_revision + 1;
+    m_deferred.clear();
+    startWorker();
+}
+
+void LiriSyntaxHighlighter::setViewportOnly(bool viewportOnly)
+{
+    if (viewportOnly == m_viewportOnly)
+        return;
+    m_viewportOnly = viewportOnly;
+    // Blocks left out before are pending still
+    if (!viewportOnly && !m_firstPending.isNull())
+        startWorker();
+}
+
+void LiriSyntaxHighlighter::setVisibleBlocks(int first, int last)
+{
+    m_visibleFirst = first;
+    m_visibleLast = last;
+    if (m_firstPending.isNull() || !document())
+        return;
+
+    // Only restart the worker if it has something to do there
+    for (QTextBlock block = document()->findBlockByNumber(first);
+         block.isValid() && block.blockNumber() <= last + LookaheadBlocks; block = block.next()) {
+        if (block.userState() == PendingState) {
+            if (!m_restartTimer.isActive())
+                m_restartTimer.start(ViewportRestartDelay);
+            return;
+        }
+    }
+}
+
+QString LiriSyntaxHighlighter::regexProfile() const
+{
+    if (!m_program || !m_program->profile())
+        return QString();
+    return m_program->profile()->report();
+}
+
+void LiriSyntaxHighlighter::dumpRegexProfile()
+{
+    if (m_program && m_program->profile())
+        qDebug().noquote() << "Regex profile of" << m_program->name(0) << "\n" << regexProfile();
 }
 
 QString LiriSyntaxHighlighter::highlightedFragment(int position, int blockCount, const QFont &font)
@@ -127,338 +221,304 @@ QString LiriSyntaxHighlighter::highlightedFragment(int position, int blockCount,
 
 void LiriSyntaxHighlighter::highlightBlock(const QString &text)
 {
-    if (!m_lang || !m_defStyles)
+    if (!m_engine)
         return;
 
-    QList<HighlightData::ContainerInfo> previousBlockContainers;
-    if (currentBlock().previous().isValid())
-        previousBlockContainers =
-            static_cast<HighlightData *>(currentBlock().previous().userData())->containers;
-    else {
-        previousBlockContainers = QList<HighlightData::ContainerInfo>(
-            { { m_lang, QRegularExpression(), QList<QSharedPointer<LanguageContext>>() } });
+    const QTextBlock block = currentBlock();
+    HighlightEngine::Result result;
+    if (m_resultsBlock >= 0 && block.blockNumber() >= m_resultsBlock
+        && block.blockNumber() < m_resultsBlock + m_results.size()) {
+        result = m_results.at(block.blockNumber() - m_resultsBlock);
+    } else if (currentBlockState() == PendingState
+               || (block.previous().isValid() && previousBlockState() == PendingState)) {
+        // The worker hasn't got here yet, keep what the block has until it does
+        keepFormats(block);
+        setCurrentBlockState(PendingState);
+        return;
+    } else if ((block.previous().isValid() && previousBlockState() == DeferredState)
+               || (m_slice.isValid() && m_slice.elapsed() >= SliceBudget)) {
+        // Continue from here in the next slice
+        keepFormats(block);
+        if (!block.previous().isValid() || previousBlockState() != DeferredState)
+            m_deferred.append(QTextCursor(block));
+        /* Edited blocks have to be highlighted when the cascade resumes, others
+         * keep their state, so QSyntaxHighlighter stops here for now
+         */
+        if (block.position() < m_editEnd || currentBlockState() < 0)
+            setCurrentBlockState(DeferredState);
+        if (!m_continueTimer.isActive())
+            m_continueTimer.start();
+        return;
+    } else {
+        result = m_engine->highlightLine(text, previousBlockState(), !block.previous().isValid());
     }
 
-    HighlightData *currentStateData = static_cast<HighlightData *>(currentBlockUserData());
-    if (!currentStateData) {
-        currentStateData = new HighlightData();
-        setCurrentBlockUserData(currentStateData);
+    if (result.skipped && !currentBlockUserData()) {
+        qWarning() << "Line" << block.blockNumber() + 1 << "is too long or slow to highlight";
+        setCurrentBlockUserData(new SkippedLineData);
+    } else if (!result.skipped && currentBlockUserData()) {
+        setCurrentBlockUserData(nullptr);
     }
-    auto containerStack = previousBlockContainers;
-
-    int start = 0;
-    bool highlightingProgresses = true;
-    startContainer(containerStack, containerStack.first().containerRef, start, text.length());
-
-    while (highlightingProgresses) {
-        auto &containerInfo = containerStack.first();
-        int containerIdx = 0;
-
-        QRegularExpressionMatch containerEndMatch;
-        for (int i = 0; i < containerStack.size(); ++i) {
-            QRegularExpressionMatch tmp;
-            if (containerStack[i].endRegex.pattern() != QLatin1String(""))
-                tmp = containerStack[i].endRegex.match(text, start);
-            if (!tmp.hasMatch()
-                && containerStack[i]
-                       .containerRef->base.staticCast<LanguageContextContainer>()
-                       ->endAtLineEnd)
-                tmp = QRegularExpression(QStringLiteral("$")).match(text, start);
-            if (tmp.hasMatch()
-                && (!containerEndMatch.hasMatch()
-                    || tmp.capturedStart() <= containerEndMatch.capturedStart())) {
-                containerIdx = i;
-                containerEndMatch = tmp;
-            }
-            if (containerStack[i]
-                    .containerRef->base.staticCast<LanguageContextContainer>()
-                    ->extendParent)
-                break;
-        }
-
-        Match bestMatch = findMatch(text, start,
-                                    containerEndMatch.hasMatch() ? containerEndMatch.capturedStart()
-                                                                 : text.length(),
-                                    containerInfo.containerRef, containerInfo);
-
-        if (!bestMatch.match.hasMatch()) {
-            if (!containerEndMatch.hasMatch()) {
-                start = text.length();
-                highlightingProgresses = false;
-                continue;
-            } else {
-                start = containerEndMatch.capturedEnd();
-                endNthContainer(containerStack, containerIdx, start, text.length(),
-                                containerEndMatch);
-                continue;
-            }
-        } else if (containerEndMatch.hasMatch()
-                   && containerEndMatch.capturedStart() <= bestMatch.match.capturedStart()) {
-            start = containerEndMatch.capturedEnd();
-            endNthContainer(containerStack, containerIdx, start, text.length(), containerEndMatch);
-            continue;
-        }
-
-        switch (bestMatch.context->type) {
-        case LanguageContext::Keyword: {
-            auto kw = bestMatch.context->base.staticCast<LanguageContextKeyword>();
+    for (const QTextLayout::FormatRange &range : qAsConst(result.formats))
+        setFormat(range.start, range.length, range.format);
+    setCurrentBlockState(result.state);
+}
 
-            if (kw->onceOnly) {
-                containerInfo.forbiddenContexts.append(bestMatch.context);
-            }
+void LiriSyntaxHighlighter::keepFormats(const QTextBlock &block)
+{
+    for (const QTextLayout::FormatRange &range : block.layout()->formats())
+        setFormat(range.start, range.length, range.format);
+}
 
-            if (m_styleMap.contains(bestMatch.context->styleId))
-                setFormat(bestMatch.match.capturedStart(), bestMatch.match.capturedLength(),
-                          m_defStyles->styles[m_styleMap[bestMatch.context->styleId]]);
+void LiriSyntaxHighlighter::init()
+{
+    m_states = QSharedPointer<HighlightStateTable>::create();
+    m_revision = 0;
+    m_resultsBlock = -1;
+    m_visibleFirst = 0;
+    m_visibleLast = 0;
+    m_checkpointRevision = 0;
+    m_changeDepth = 0;
+    m_editEnd = -1;
+    m_continuing = false;
+    m_workerWaiting = false;
+    m_viewportOnly = false;
+
+    m_workerThread = new QThread;
+    m_worker = new HighlightWorker;
+    m_worker->moveToThread(m_workerThread);
+    connect(m_workerThread, &QThread::finished, m_worker, &HighlightWorker::deleteLater);
+    connect(m_worker, &HighlightWorker::highlighted, this, &LiriSyntaxHighlighter::applyResults);
+    connect(m_worker, &HighlightWorker::stateReached, this, &LiriSyntaxHighlighter::addCheckpoint);
+    m_workerThread->start(QThread::LowPriority);
+
+    // Coalesce the restarts caused by a burst of edits or scrolling
+    m_restartTimer.setSingleShot(true);
+    connect(&m_restartTimer, &QTimer::timeout, this, &LiriSyntaxHighlighter::startWorker);
+
+    m_continueTimer.setSingleShot(true);
+    m_continueTimer.setInterval(0);
+    connect(&m_continueTimer, &QTimer::timeout, this, &LiriSyntaxHighlighter::continueHighlighting);
+
+    m_document = document();
+    if (m_document) {
+        setDocument(nullptr);
+        attachDocument();
+    }
+}
 
-            start = bestMatch.match.capturedEnd();
+void LiriSyntaxHighlighter::attachDocument()
+{
+    // contentsChanging() has to run before QSyntaxHighlighter starts highlighting the edit
+    connect(m_document, &QTextDocument::contentsChange, this,
+            &LiriSyntaxHighlighter::contentsChanging);
+    setDocument(m_document);
+    connect(m_document, &QTextDocument::contentsChange, this,
+            &LiriSyntaxHighlighter::documentChanged);
+}
 
-            if (kw->endParent)
-                endNthContainer(containerStack, 0, start, text.length());
-            break;
-        }
-        case LanguageContext::Simple: {
-            auto simple = bestMatch.context->base.staticCast<LanguageContextSimple>();
-
-            if (simple->onceOnly) {
-                containerInfo.forbiddenContexts.append(bestMatch.context);
-            }
-
-            if (m_styleMap.contains(bestMatch.context->styleId))
-                setFormat(bestMatch.match.capturedStart(), bestMatch.match.capturedLength(),
-                          m_defStyles->styles[m_styleMap[bestMatch.context->styleId]]);
-
-            start = bestMatch.match.capturedEnd();
-
-            for (const auto &inc : qAsConst(simple->includes)) {
-                if (inc->type == LanguageContext::SubPattern) {
-                    auto subPattern = inc->base.staticCast<LanguageContextSubPattern>();
-                    int mStart = subPattern->groupName.isNull()
-                        ? bestMatch.match.capturedStart(subPattern->groupId)
-                        : bestMatch.match.capturedStart(subPattern->groupName);
-                    int mLen = subPattern->groupName.isNull()
-                        ? bestMatch.match.capturedLength(subPattern->groupId)
-                        : bestMatch.match.capturedLength(subPattern->groupName);
-                    if (m_styleMap.contains(inc->styleId))
-                        setFormat(mStart, mLen, m_defStyles->styles[m_styleMap[inc->styleId]]);
-                }
-            }
-            if (simple->endParent)
-                endNthContainer(containerStack, 0, start, text.length());
-            break;
-        }
-        case LanguageContext::Container: {
-            auto container = bestMatch.context->base.staticCast<LanguageContextContainer>();
+void LiriSyntaxHighlighter::detachDocument()
+{
+    disconnect(m_document, &QTextDocument::contentsChange, this,
+               &LiriSyntaxHighlighter::contentsChanging);
+    disconnect(m_document, &QTextDocument::contentsChange, this,
+               &LiriSyntaxHighlighter::documentChanged);
+    // Clears the formats of all blocks
+    setDocument(nullptr);
+}
 
-            if (container->onceOnly) {
-                containerInfo.forbiddenContexts.append(bestMatch.context);
-            }
+void LiriSyntaxHighlighter::setEnabled(bool enabled)
+{
+    if (!m_document || enabled == isEnabled())
+        return;
 
-            start = bestMatch.match.capturedEnd();
-            startContainer(containerStack, bestMatch.context, start, text.length(),
-                           bestMatch.match);
-            break;
-        }
-        default: {
-            qDebug() << "Internal error during highlighting";
-            qDebug() << "Impossible context type";
-            Q_ASSERT(false);
-        }
-        }
+    // Nothing the worker or the time slices were up to applies anymore
+    m_worker->cancel(++m_revision);
+    m_restartTimer.stop();
+    m_continueTimer.stop();
+    m_deferred.clear();
+    m_workerWaiting = false;
+    m_firstPending = QTextCursor();
+    m_checkpoints.clear();
+    m_checkpointRevision = m_revision;
+
+    if (enabled) {
+        attachDocument();
+        if (m_engine)
+            rehighlightInBackground();
+    } else {
+        detachDocument();
     }
-
-    currentStateData->containers = containerStack;
-    setCurrentBlockState(static_cast<int>(qHash(currentStateData->containers)));
 }
 
-void LiriSyntaxHighlighter::endNthContainer(QList<HighlightData::ContainerInfo> &containers, int n,
-                                            int offset, int length,
-                                            const QRegularExpressionMatch &endMatch)
+void LiriSyntaxHighlighter::clearFormats()
 {
-    for (int i = 0; i < n; ++i)
-        containers.removeFirst();
-
-    if (endMatch.hasMatch()) {
-        for (const auto &inc :
-             qAsConst(containers.first()
-                          .containerRef->base.staticCast<LanguageContextContainer>()
-                          ->includes)) {
-            if (inc->type == LanguageContext::SubPattern) {
-                auto subPattern = inc->base.staticCast<LanguageContextSubPattern>();
-                if (subPattern->where == LanguageContextSubPattern::End && endMatch.hasMatch()) {
-                    int endStart = subPattern->groupName.isNull()
-                        ? endMatch.capturedStart(subPattern->groupId)
-                        : endMatch.capturedStart(subPattern->groupName);
-                    if (endStart >= 0) {
-                        int endLen = subPattern->groupName.isNull()
-                            ? endMatch.capturedLength(subPattern->groupId)
-                            : endMatch.capturedLength(subPattern->groupName);
-                        if (m_styleMap.contains(inc->styleId))
-                            setFormat(endStart, endLen,
-                                      m_defStyles->styles[m_styleMap[inc->styleId]]);
-                    }
-                }
-            }
-        }
+    // Unlike rehighlight(), this leaves alone the blocks which have no formats anyway
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+        if (block.layout()->formats().isEmpty())
+            continue;
+        block.layout()->clearFormats();
+        document()->markContentsDirty(block.position(), block.length());
     }
+}
 
-    while (containers.first().containerRef->base.staticCast<LanguageContextContainer>()->endParent)
-        containers.removeFirst();
-    containers.removeFirst();
-    startContainer(containers, containers.first().containerRef, offset, length);
+void LiriSyntaxHighlighter::updateEngines()
+{
+    if (m_program && m_defStyles) {
+        QVector<QTextCharFormat> formats;
+        formats.reserve(m_language->styles.size());
+        for (const QString &style : qAsConst(m_language->styles))
+            formats.append(m_defStyles->styles.value(style));
+
+        m_engine = QSharedPointer<HighlightEngine>::create(m_program, formats, m_states);
+        m_workerEngine = QSharedPointer<HighlightEngine>::create(m_program, formats, m_states);
+    } else {
+        m_engine.reset();
+        m_workerEngine.reset();
+    }
 }
 
-void LiriSyntaxHighlighter::startContainer(QList<HighlightData::ContainerInfo> &containers,
-                                           QSharedPointer<LanguageContext> container, int offset,
-                                           int length, const QRegularExpressionMatch &startMatch)
+void LiriSyntaxHighlighter::startWorker()
 {
-    int start = startMatch.hasMatch() ? startMatch.capturedStart() : offset;
-    // Highlight the whole text
-    QTextCharFormat containerFormat;
-    if (m_styleMap.contains(container->styleId))
-        containerFormat = m_defStyles->styles[m_styleMap[container->styleId]];
-    else {
-        for (int i = 0; i < containers.size(); ++i) {
-            if (m_styleMap.contains(containers[i].containerRef->styleId)) {
-                containerFormat =
-                    m_defStyles->styles[m_styleMap[containers[i].containerRef->styleId]];
-                break;
-            }
-        }
+    m_worker->setRevision(++m_revision);
+    if (m_firstPending.isNull() || !m_workerEngine)
+        return;
+
+    QTextBlock block = m_firstPending.block();
+    while (block.isValid() && block.userState() != PendingState)
+        block = block.next();
+    if (!block.isValid()) {
+        m_firstPending = QTextCursor();
+        return;
     }
-    setFormat(container->base.staticCast<LanguageContextContainer>()->styleInside ? offset : start,
-              length, containerFormat);
-
-    if (startMatch.hasMatch()) {
-        // Resolve references to start subpatterns from end regex
-        QRegularExpression endRegex = container->base.staticCast<LanguageContextContainer>()->end;
-        QString endPattern = endRegex.pattern();
-        QRegularExpression startRefRegex = QRegularExpression(QStringLiteral("\\\\%{(.+?)@start}"));
-        QRegularExpressionMatch startRefMatch;
-        while ((startRefMatch = startRefRegex.match(endPattern)).hasMatch()) {
-            QString groupName = startRefMatch.captured(1);
-            bool isId;
-            int id = groupName.toInt(&isId);
-            endPattern.replace(startRefMatch.capturedStart(), startRefMatch.capturedLength(),
-                               QRegularExpression::escape(isId ? startMatch.captured(id)
-                                                               : startMatch.captured(groupName)));
-        }
-        if (endRegex.pattern() != endPattern) // Don't make regex dirty if there were no changes
-            endRegex.setPattern(endPattern);
-
-        // Highlight start subpatterns
-        for (const auto &inc :
-             qAsConst(container->base.staticCast<LanguageContextContainer>()->includes)) {
-            if (inc->type == LanguageContext::SubPattern) {
-                auto subPattern = inc->base.staticCast<LanguageContextSubPattern>();
-                if (subPattern->where == LanguageContextSubPattern::Start) {
-                    int startStart = subPattern->groupName.isNull()
-                        ? startMatch.capturedStart(subPattern->groupId)
-                        : startMatch.capturedStart(subPattern->groupName);
-                    if (startStart >= 0) {
-                        int startLen = subPattern->groupName.isNull()
-                            ? startMatch.capturedLength(subPattern->groupId)
-                            : startMatch.capturedLength(subPattern->groupName);
-                        if (m_styleMap.contains(inc->styleId))
-                            setFormat(startStart, startLen,
-                                      m_defStyles->styles[m_styleMap[inc->styleId]]);
-                    }
-                }
-            }
+    m_firstPending = QTextCursor(block);
+    // The state to start from isn't known yet, continueHighlighting() starts the worker then
+    m_workerWaiting = block.previous().isValid() && block.previous().userState() == DeferredState;
+    if (m_workerWaiting)
+        return;
+
+    int entryState = block.previous().isValid() ? block.previous().userState() : -1;
+    QTextBlock last = document()->lastBlock();
+    if (m_viewportOnly) {
+        // Start from the closest known state above the window instead of the first pending block
+        auto checkpoint = m_checkpoints.upperBound(m_visibleFirst);
+        if (checkpoint != m_checkpoints.begin()
+            && (--checkpoint).key() > block.blockNumber()) {
+            block = document()->findBlockByNumber(checkpoint.key());
+            entryState = checkpoint.value();
         }
-        containers.prepend({ container, endRegex, QList<QSharedPointer<LanguageContext>>() });
+        // Nothing after the window is highlighted, so its text isn't needed
+        const QTextBlock windowLast =
+            document()->findBlockByNumber(m_visibleLast + LookaheadBlocks);
+        if (windowLast.isValid() && windowLast.blockNumber() >= block.blockNumber())
+            last = windowLast;
     }
+    QTextCursor text(block);
+    text.setPosition(last.position() + last.length() - 1, QTextCursor::KeepAnchor);
+
+    HighlightWorker::Job job = { m_workerEngine,
+                                 m_revision,
+                                 block.blockNumber(),
+                                 entryState,
+                                 m_visibleFirst,
+                                 m_visibleLast + LookaheadBlocks + 1,
+                                 m_viewportOnly,
+                                 text.selectedText() };
+    HighlightWorker *worker = m_worker;
+    QMetaObject::invokeMethod(m_worker, [worker, job]() { worker->highlight(job); },
+                              Qt::QueuedConnection);
 }
 
-LiriSyntaxHighlighter::Match LiriSyntaxHighlighter::findMatch(
-    const QString &text, int offset, int potentialEnd, QSharedPointer<LanguageContext> context,
-    HighlightData::ContainerInfo &currentContainerInfo, bool rootContext)
+void LiriSyntaxHighlighter::applyResults(int revision, int firstBlock,
+                                         const QVector<HighlightEngine::Result> &results)
 {
-    switch (context->type) {
-    case LanguageContext::Keyword: {
-        if (context->base.staticCast<LanguageContextKeyword>()->firstLineOnly
-            && currentBlock().position() != 0)
-            break;
-        if (currentContainerInfo.forbiddenContexts.contains(context))
-            break;
-
-        QStringRef allowedText = QStringRef(&text);
-        if (!context->base.staticCast<LanguageContextKeyword>()->extendParent)
-            allowedText = allowedText.left(potentialEnd);
-        Match bestMatch;
-        for (const QRegularExpression &keyword :
-             qAsConst(context->base.staticCast<LanguageContextKeyword>()->keywords)) {
-            if (keyword.pattern().isEmpty() && offset >= text.length())
-                continue;
-            QRegularExpressionMatch kwMatch = keyword.match(allowedText, offset);
-            if (kwMatch.hasMatch()) {
-                Match match = { kwMatch, context };
-                if (match < bestMatch)
-                    bestMatch = match;
-            }
-        }
-        return bestMatch;
-    }
-    case LanguageContext::Simple: {
-        if (context->base.staticCast<LanguageContextSimple>()->firstLineOnly
-            && currentBlock().position() != 0)
-            break;
-        if (currentContainerInfo.forbiddenContexts.contains(context))
-            break;
-        if (context->base.staticCast<LanguageContextSimple>()->match.pattern().isEmpty()
-            && offset >= text.length())
-            break;
-
-        QStringRef allowedText = QStringRef(&text);
-        if (!context->base.staticCast<LanguageContextSimple>()->extendParent)
-            allowedText = allowedText.left(potentialEnd);
-        QRegularExpressionMatch match =
-            context->base.staticCast<LanguageContextSimple>()->match.match(allowedText, offset);
-        return { match, context };
+    m_worker->batchApplied();
+    if (revision != m_revision || !document())
+        return;
+    const QTextBlock first = document()->findBlockByNumber(firstBlock);
+    if (!first.isValid())
+        return;
+
+    /* Results go through highlightBlock, so that QSyntaxHighlighter updates the layouts.
+     * Resetting the states makes it continue over the whole batch.
+     */
+    QTextBlock block = first;
+    for (int i = 0; i < results.size() && block.isValid(); ++i) {
+        block.setUserState(-1);
+        block = block.next();
     }
-    case LanguageContext::Container: {
-        if (context->base.staticCast<LanguageContextContainer>()->firstLineOnly
-            && currentBlock().position() != 0)
-            break;
-        if (currentContainerInfo.forbiddenContexts.contains(context))
-            break;
-        if (context->base.staticCast<LanguageContextContainer>()->start.pattern().isEmpty()
-            && offset >= text.length())
-            break;
-
-        if (context->base.staticCast<LanguageContextContainer>()->includesOnly || rootContext) {
-            Match bestMatch;
-            for (const auto &inc :
-                 qAsConst(context->base.staticCast<LanguageContextContainer>()->includes)) {
-                Match match =
-                    findMatch(text, offset, potentialEnd, inc, currentContainerInfo, false);
-                if (match < bestMatch)
-                    bestMatch = match;
-            }
-            return bestMatch;
-        } else {
-            QStringRef allowedText = QStringRef(&text);
-            if (!context->base.staticCast<LanguageContextContainer>()->extendParent)
-                allowedText = allowedText.left(potentialEnd);
-            QRegularExpressionMatch startMatch =
-                context->base.staticCast<LanguageContextContainer>()->start.match(allowedText,
-                                                                                  offset);
-            return { startMatch, context };
+    if (!m_firstPending.isNull() && m_firstPending.block().blockNumber() >= firstBlock
+        && m_firstPending.block().blockNumber() < firstBlock + results.size())
+        m_firstPending = block.isValid() ? QTextCursor(block) : QTextCursor();
+
+    m_results = results;
+    m_resultsBlock = firstBlock;
+    rehighlightBlock(first);
+    m_results.clear();
+    m_resultsBlock = -1;
+}
+
+void LiriSyntaxHighlighter::addCheckpoint(int revision, int block, int state)
+{
+    // Jobs restarted for scrolling still work on the same text, only edits make states stale
+    if (revision >= m_checkpointRevision)
+        m_checkpoints.insert(block, state);
+}
+
+void LiriSyntaxHighlighter::continueHighlighting()
+{
+    m_slice.start();
+    m_editEnd = -1;
+    while (!m_deferred.isEmpty() && m_slice.elapsed() < SliceBudget) {
+        // Resume from the earliest block, the cascade may well go over the later ones
+        int earliest = 0;
+        for (int i = 1; i < m_deferred.size(); ++i) {
+            if (m_deferred.at(i).position() < m_deferred.at(earliest).position())
+                earliest = i;
         }
+        const QTextBlock block = m_deferred.takeAt(earliest).block();
+
+        m_continuing = true;
+        rehighlightBlock(block);
+        m_continuing = false;
     }
-    default: {
-        break;
-    }
-    }
+    m_slice.invalidate();
+    if (!m_deferred.isEmpty())
+        m_continueTimer.start();
+    else if (m_workerWaiting)
+        startWorker();
+}
 
-    return { QRegularExpressionMatch(), QSharedPointer<LanguageContext>() };
+void LiriSyntaxHighlighter::contentsChanging(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    // QSyntaxHighlighter's own format changes are reported while it handles an edit
+    if (m_changeDepth++ > 0 || m_resultsBlock >= 0 || m_continuing)
+        return;
+
+    m_slice.start();
+    m_editEnd = position + charsAdded;
 }
 
-bool LiriSyntaxHighlighter::Match::operator<(const Match &other)
+void LiriSyntaxHighlighter::documentChanged(int position, int charsRemoved, int charsAdded)
 {
-    if (!this->match.hasMatch())
-        return false;
-    if (!other.match.hasMatch())
-        return true;
-    return this->match.capturedStart() < other.match.capturedStart();
+    if (--m_changeDepth > 0)
+        return;
+    // The cascade of the change is done or deferred, later ones get slices of their own
+    if (m_resultsBlock < 0 && !m_continuing) {
+        m_slice.invalidate();
+        m_editEnd = -1;
+    }
+    // Applying results changes formats only
+    if (m_resultsBlock >= 0 || m_continuing || (charsRemoved == 0 && charsAdded == 0))
+        return;
+
+    // Results of the worker don't match the text anymore
+    m_worker->setRevision(++m_revision);
+    // States of the blocks after the edited one may change along with their numbers
+    const int editedBlock = document()->findBlock(position).blockNumber();
+    m_checkpoints.erase(m_checkpoints.upperBound(editedBlock), m_checkpoints.end());
+    m_checkpointRevision = m_revision;
+    if (!m_firstPending.isNull())
+        m_restartTimer.start(0);
 }
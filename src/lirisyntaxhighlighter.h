@@ -21,11 +21,26 @@
 #define LIRISYNTAXHIGHLIGHTER_H
 
 #include <QSyntaxHighlighter>
-#include <QRegularExpressionMatch>
-#include "languagecontext.h"
-#include "highlightdata.h"
+#include <QMap>
+#include <QPointer>
+#include <QTextCursor>
+#include <QElapsedTimer>
+#include <QTimer>
+#include "contextprogram.h"
+#include "highlightengine.h"
+#include "highlightstatetable.h"
+#include "highlightworker.h"
+#include "languagecache.h"
 #include "languagedefaultstyles.h"
 
+class QThread;
+
+/* Lines are highlighted by a worker thread after the language changes,
+ * the visible blocks first. Blocks waiting for its results keep their formats,
+ * edits elsewhere are highlighted right away. Highlighting in the GUI thread
+ * is split into time slices, so an edit that changes the state of every
+ * following line doesn't block the event loop until they are all done.
+ */
 class LiriSyntaxHighlighter : public QSyntaxHighlighter
 {
     Q_OBJECT
@@ -33,37 +48,88 @@ public:
     LiriSyntaxHighlighter(QObject *parent = nullptr);
     LiriSyntaxHighlighter(QTextDocument *parent);
     ~LiriSyntaxHighlighter();
-    void setLanguage(QSharedPointer<LanguageContext> lang, const QHash<QString, QString> &styleMap);
+    void setLanguage(QSharedPointer<const CompiledLanguage> language);
     void setDefaultStyles(QSharedPointer<LanguageDefaultStyles> defStyles);
 
     QString highlightedFragment(int position, int blockCount, const QFont &font);
 
-protected:
-    struct Match
-    {
-        QRegularExpressionMatch match;
-        QSharedPointer<LanguageContext> context;
+    /* A disabled highlighter is detached from its document, which then has no formats
+     * and is edited without any highlighting work. For plain text.
+     */
+    void setEnabled(bool enabled);
+    inline bool isEnabled() const { return document() != nullptr; }
 
-        inline bool operator<(const Match &other);
-    };
+    /* Only the visible blocks and a few after them are highlighted, the ones above
+     * only as far as needed to know their states. For large documents.
+     */
+    void setViewportOnly(bool viewportOnly);
+    void setVisibleBlocks(int first, int last);
+    // Report of the regex profile of the current language, empty unless profiling is enabled
+    QString regexProfile() const;
 
-    void highlightBlock(const QString &text);
+public slots:
+    void rehighlightInBackground();
 
-    void endNthContainer(QList<HighlightData::ContainerInfo> &containers, int n, int offset,
-                         int length,
-                         const QRegularExpressionMatch &endMatch = QRegularExpressionMatch());
+protected:
+    void highlightBlock(const QString &text);
 
-    void startContainer(QList<HighlightData::ContainerInfo> &containers,
-                        QSharedPointer<LanguageContext> container, int offset, int length,
-                        const QRegularExpressionMatch &startMatch = QRegularExpressionMatch());
+private slots:
+    void startWorker();
+    void applyResults(int revision, int firstBlock,
+                      const QVector<HighlightEngine::Result> &results);
+    void addCheckpoint(int revision, int block, int state);
+    void continueHighlighting();
+    void contentsChanging(int position, int charsRemoved, int charsAdded);
+    void documentChanged(int position, int charsRemoved, int charsAdded);
 
-    Match findMatch(const QString &text, int offset, int potentialEnd,
-                    QSharedPointer<LanguageContext> context,
-                    HighlightData::ContainerInfo &currentContainerInfo, bool rootContext = true);
+private:
+    void init();
+    void attachDocument();
+    void detachDocument();
+    void clearFormats();
+    void updateEngines();
+    void keepFormats(const QTextBlock &block);
+    void dumpRegexProfile();
 
-    QSharedPointer<LanguageContext> m_lang;
+    // Shared with the other documents of the same language
+    QSharedPointer<const CompiledLanguage> m_language;
+    // The program of the language, shared by the engines
+    QSharedPointer<const ContextProgram> m_program;
     QSharedPointer<LanguageDefaultStyles> m_defStyles;
-    QHash<QString, QString> m_styleMap;
+    // Block states are ids of this table
+    QSharedPointer<HighlightStateTable> m_states;
+    QSharedPointer<HighlightEngine> m_engine;
+    QSharedPointer<HighlightEngine> m_workerEngine;
+
+    // Kept while the highlighter is disabled
+    QPointer<QTextDocument> m_document;
+    QThread *m_workerThread;
+    HighlightWorker *m_worker;
+    QTimer m_restartTimer;
+    int m_revision;
+    // No block before it waits for the worker, null when none does
+    QTextCursor m_firstPending;
+    int m_visibleFirst;
+    int m_visibleLast;
+    // Entry states of blocks reported by the worker, by block number
+    QMap<int, int> m_checkpoints;
+    // Checkpoints of jobs older than this don't match the text
+    int m_checkpointRevision;
+    // The batch being applied
+    QVector<HighlightEngine::Result> m_results;
+    int m_resultsBlock;
+
+    QElapsedTimer m_slice;
+    QTimer m_continueTimer;
+    // Blocks to resume highlighting from
+    QList<QTextCursor> m_deferred;
+    int m_changeDepth;
+    // End of the text inserted by the edit being highlighted
+    int m_editEnd;
+    bool m_continuing;
+    // The worker starts once the deferred blocks before the pending ones are done
+    bool m_workerWaiting;
+    bool m_viewportOnly;
 };
 
 #endif // LIRISYNTAXHIGHLIGHTER_H
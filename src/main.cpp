@@ -31,13 +31,80 @@
 #include <QDir>
 #include <QDebug>
 #include <QStandardPaths>
+#include <QEventLoop>
 
 #include "documenthandler.h"
 #include "historymanager.h"
+#include "htmlexporter.h"
 #include "languagemanager.h"
 
+static bool isExportRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--export-html") == 0)
+            return true;
+    }
+    return false;
+}
+
+// Highlights the given files into HTML files without loading any QML
+static int exportHtml(int argc, char *argv[])
+{
+    // Formats need a GUI application, but nothing is shown
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+
+    // Same as the editor, so that the language database is shared
+    app.setOrganizationName(QStringLiteral("Liri"));
+    app.setOrganizationDomain(QStringLiteral("liri.io"));
+    app.setApplicationName(QStringLiteral("Text"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        app.translate("main", "Writes syntax highlighted copies of files as HTML."));
+    parser.addHelpOption();
+    QCommandLineOption exportOption(QStringLiteral("export-html"),
+                                    app.translate("main", "Export the files as HTML."));
+    parser.addOption(exportOption);
+    QCommandLineOption jobsOption(
+        { QStringLiteral("j"), QStringLiteral("jobs") },
+        app.translate("main", "Number of files highlighted at once, all cores by default."),
+        app.translate("main", "N"));
+    parser.addOption(jobsOption);
+    QCommandLineOption outputOption(
+        { QStringLiteral("o"), QStringLiteral("output-dir") },
+        app.translate("main", "Directory for the HTML files, next to the files by default."),
+        app.translate("main", "directory"));
+    parser.addOption(outputOption);
+    parser.addPositionalArgument(app.translate("main", "files..."),
+                                 app.translate("main", "Files to export."));
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty())
+        parser.showHelp(1);
+
+    // Languages can only be found once the database is up to date
+    LanguageManager *lManager = LanguageManager::getInstance();
+    QEventLoop loop;
+    QObject::connect(lManager, &LanguageManager::dbUpdated, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    HtmlExporter exporter(QSharedPointer<LanguageDefaultStyles>::create());
+    exporter.setOutputDirectory(parser.value(outputOption));
+    const int failures = exporter.exportFiles(files, parser.value(jobsOption).toInt());
+
+    lManager->deleteLater();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    return failures > 0 ? 1 : 0;
+}
+
 int main(int argc, char *argv[])
 {
+    if (isExportRequested(argc, argv))
+        return exportHtml(argc, argv);
+
     QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QQuickStyle::setStyle(QStringLiteral("Material"));
     QApplication app(argc, argv);
@@ -1,5 +1,5 @@
 /*
- * Copyright © 2016-2017 Andrew Penkrat
+ * Copyright © 2017 Andrew Penkrat
  *
  * This file is part of Liri Text.
  *
@@ -17,17 +17,11 @@
  * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "highlightdata.h"
+#include "precompiledlanguages.h"
 
-HighlightData::HighlightData() {}
-
-HighlightData::~HighlightData() {}
-
-uint qHash(const HighlightData::ContainerInfo &t, uint seed)
+// Linked instead of the generated source when the specs aren't compiled at build time
+QByteArray precompiledLanguage(const QString &fileName)
 {
-    /* Since ContainerInfo's fields have different types
-     * and their hashes are computed with different algorithms,
-     * we can simply combine them with xor
-     */
-    return qHash(t.containerRef, seed) ^ qHash(t.endRegex, seed) ^ qHash(t.forbiddenContexts, seed);
+    Q_UNUSED(fileName);
+    return QByteArray();
 }
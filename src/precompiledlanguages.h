@@ -0,0 +1,34 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRECOMPILEDLANGUAGES_H
+#define PRECOMPILEDLANGUAGES_H
+
+#include <QByteArray>
+#include <QString>
+
+/* Bundled languages compiled at build time, defined in a source file
+ * generated by liri-text-langc when TEXT_WITH_PRECOMPILED_LANGUAGES is on,
+ * and in noprecompiledlanguages.cpp otherwise.
+ * Returns the data LanguageCache stores for the spec with the given file name,
+ * without copying it, or an empty array if there is none.
+ */
+QByteArray precompiledLanguage(const QString &fileName);
+
+#endif // PRECOMPILEDLANGUAGES_H
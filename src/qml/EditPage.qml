@@ -55,6 +55,12 @@ FluidControls.Page {
                           document.textFragment(mainArea.cursorPosition, 7))
     }
 
+    function updateVisibleRange() {
+        // Lets the visible lines be highlighted first
+        document.setVisibleRange(mainArea.positionAt(0, flickable.contentY),
+                                 mainArea.positionAt(mainArea.width, flickable.contentY + flickable.height))
+    }
+
     Component.onCompleted: {
         console.log("edit page completed")
 
@@ -62,13 +68,22 @@ FluidControls.Page {
             var editingInfo = History.getFileEditingInfo(documentUrl)
             mainArea.cursorPosition = editingInfo.cursorPosition ? editingInfo.cursorPosition : 0
             flickable.contentY      = editingInfo.scrollPosition ? editingInfo.scrollPosition : 0
+            updateVisibleRange()
             if(!anonymous) {
                 touchFileOnCursorPosition()
             }
         }
     }
 
-    title: anonymous ? qsTr("New Document") : document.documentTitle
+    title: {
+        var name = anonymous ? qsTr("New Document") : document.documentTitle
+        // Tell why a large file looks different
+        if(document.tier === DocumentHandler.ViewportTier)
+            return qsTr("%1 (large file)").arg(name)
+        if(document.tier === DocumentHandler.PlainTier)
+            return qsTr("%1 (plain text)").arg(name)
+        return name
+    }
     appBar.maxActionCount: 2
 
     actions: [
@@ -292,6 +307,9 @@ FluidControls.Page {
         id: flickable
         anchors.fill: parent
 
+        onContentYChanged: page.updateVisibleRange()
+        onHeightChanged: page.updateVisibleRange()
+
         TextArea.flickable: TextArea {
             id: mainArea
 
@@ -300,7 +318,8 @@ FluidControls.Page {
             selectByMouse: true
             textMargin: 8
             font: defaultFont
-            wrapMode: Text.WrapAtWordBoundaryOrAnywhere
+            wrapMode: document.tier === DocumentHandler.PlainTier ? TextEdit.NoWrap
+                                                                  : TextEdit.WrapAtWordBoundaryOrAnywhere
             text: document.text
 
             Keys.onPressed: {
@@ -372,6 +391,27 @@ FluidControls.Page {
             text: qsTr("Select All")
             onTriggered: mainArea.selectAll()
         }
+
+        MenuSeparator { }
+
+        MenuItem {
+            text: qsTr("All Features")
+            checkable: true
+            checked: document.tier === DocumentHandler.FullTier
+            onTriggered: document.tier = DocumentHandler.FullTier
+        }
+        MenuItem {
+            text: qsTr("Highlight Visible Lines Only")
+            checkable: true
+            checked: document.tier === DocumentHandler.ViewportTier
+            onTriggered: document.tier = DocumentHandler.ViewportTier
+        }
+        MenuItem {
+            text: qsTr("Plain Text")
+            checkable: true
+            checked: document.tier === DocumentHandler.PlainTier
+            onTriggered: document.tier = DocumentHandler.PlainTier
+        }
     }
 
     DocumentHandler {
@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "regexprofile.h"
+#include <algorithm>
+
+RegexProfile::RegexProfile(const QStringList &names)
+    : m_names(names)
+    , m_counters(names.size() * KindCount)
+{
+}
+
+bool RegexProfile::isEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIsSet("LIRI_TEXT_PROFILE_REGEX");
+    return enabled;
+}
+
+QString RegexProfile::report() const
+{
+    struct Row
+    {
+        int context;
+        Kind kind;
+        quint64 attempts;
+        quint64 hits;
+        qint64 nsecs;
+    };
+
+    QVector<Row> rows;
+    qint64 total = 0;
+    for (int i = 0; i < m_counters.size(); ++i) {
+        const Counters &counters = m_counters.at(i);
+        const quint64 attempts = counters.attempts.load();
+        if (attempts == 0)
+            continue;
+        rows.append({ i / KindCount, Kind(i % KindCount), attempts, counters.hits.load(),
+                      counters.nsecs.load() });
+        total += rows.constLast().nsecs;
+    }
+    std::sort(rows.begin(), rows.end(),
+              [](const Row &a, const Row &b) { return a.nsecs > b.nsecs; });
+
+    static const char *const kinds[] = { "match", "end", "includes" };
+    QString report = QStringLiteral("%1 %2 %3 %4 %5  %6\n")
+                         .arg(QStringLiteral("msecs"), 10)
+                         .arg(QStringLiteral("share"), 6)
+                         .arg(QStringLiteral("attempts"), 10)
+                         .arg(QStringLiteral("hits"), 10)
+                         .arg(QStringLiteral("kind"), -8)
+                         .arg(QStringLiteral("context"));
+    for (const Row &row : qAsConst(rows)) {
+        report += QStringLiteral("%1 %2% %3 %4 %5  %6\n")
+                      .arg(row.nsecs / 1e6, 10, 'f', 3)
+                      .arg(total > 0 ? 100.0 * row.nsecs / total : 0.0, 5, 'f', 1)
+                      .arg(row.attempts, 10)
+                      .arg(row.hits, 10)
+                      .arg(QLatin1String(kinds[row.kind]), -8)
+                      .arg(m_names.at(row.context));
+    }
+    return report;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REGEXPROFILE_H
+#define REGEXPROFILE_H
+
+#include <QAtomicInteger>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/* Match attempts, hits and time spent per context of a language.
+ * Only collected when LIRI_TEXT_PROFILE_REGEX is set in the environment,
+ * the counters may be updated from any thread.
+ */
+class RegexProfile
+{
+    Q_DISABLE_COPY(RegexProfile)
+public:
+    enum Kind {
+        // Start regex of containers, match of simple and keyword contexts
+        Match,
+        // End regex of containers
+        End,
+        // All includes of a container matched together without a hit
+        Includes,
+        KindCount
+    };
+
+    explicit RegexProfile(const QStringList &names);
+
+    static bool isEnabled();
+
+    inline void record(Kind kind, int context, bool hit, qint64 nsecs)
+    {
+        Counters &counters = m_counters[context * KindCount + kind];
+        counters.attempts.fetchAndAddRelaxed(1);
+        if (hit)
+            counters.hits.fetchAndAddRelaxed(1);
+        counters.nsecs.fetchAndAddRelaxed(nsecs);
+    }
+
+    // One line per context and kind, the most expensive first
+    QString report() const;
+
+private:
+    struct Counters
+    {
+        QAtomicInteger<quint64> attempts;
+        QAtomicInteger<quint64> hits;
+        QAtomicInteger<qint64> nsecs;
+    };
+
+    QStringList m_names;
+    QVector<Counters> m_counters;
+};
+
+#endif // REGEXPROFILE_H
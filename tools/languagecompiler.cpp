@@ -0,0 +1,144 @@
+/*
+ * Copyright © 2017 Andrew Penkrat
+ *
+ * This file is part of Liri Text.
+ *
+ * Liri Text is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Liri Text is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Liri Text.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include "languagecache.h"
+#include "languagemanager.h"
+
+/* Compiles the bundled language specs at build time into a source file
+ * defining precompiledLanguage(), see precompiledlanguages.h.
+ * SOURCE_LANGUAGE_PATH is the spec directory of the source tree.
+ * The specs refer to each other through a language database of their own,
+ * which is kept next to the output, so nothing outside the build directory
+ * is read or written but the specs.
+ */
+
+static void writeData(QTextStream &out, const QByteArray &data)
+{
+    for (int i = 0; i < data.size(); ++i) {
+        out << (i % 16 == 0 ? "\n    " : " ") << "0x"
+            << QString::number(uchar(data.at(i)), 16).rightJustified(2, QLatin1Char('0')) << ',';
+    }
+}
+
+static bool writeSource(const QString &path, const QStringList &specs)
+{
+    QSaveFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Text)) {
+        qWarning().noquote() << path << file.errorString();
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "// Generated by liri-text-langc, do not edit\n\n"
+        << "#include \"precompiledlanguages.h\"\n\n"
+        << "namespace {\n";
+
+    QStringList fileNames;
+    for (const QString &spec : specs) {
+        const QByteArray data = LanguageCache::getInstance()->compiledData(spec);
+        if (data.isEmpty()) {
+            qWarning().noquote() << "Can't compile" << spec;
+            continue;
+        }
+        out << "\nconst unsigned char language" << fileNames.size() << "[] = {";
+        writeData(out, data);
+        out << "\n};\n";
+        fileNames.append(QFileInfo(spec).fileName());
+    }
+
+    out << "\nstruct PrecompiledLanguage\n{\n"
+        << "    const char *fileName;\n"
+        << "    const unsigned char *data;\n"
+        << "    int size;\n"
+        << "};\n\n"
+        << "const PrecompiledLanguage languages[] = {\n";
+    for (int i = 0; i < fileNames.size(); ++i) {
+        out << "    { \"" << fileNames.at(i) << "\", language" << i << ", sizeof(language" << i
+            << ") },\n";
+    }
+    out << "    { nullptr, nullptr, 0 }\n"
+        << "};\n\n"
+        << "} // namespace\n\n"
+        << "QByteArray precompiledLanguage(const QString &fileName)\n"
+        << "{\n"
+        << "    for (const PrecompiledLanguage *language = languages; language->fileName;\n"
+        << "         ++language) {\n"
+        << "        if (fileName == QLatin1String(language->fileName))\n"
+        << "            return QByteArray::fromRawData(\n"
+        << "                reinterpret_cast<const char *>(language->data), language->size);\n"
+        << "    }\n"
+        << "    return QByteArray();\n"
+        << "}\n";
+
+    out.flush();
+    return out.status() == QTextStream::Ok && file.commit();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("liri-text-langc"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Compiles language specs into a C++ source file."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("output"),
+                                 QStringLiteral("The source file to write."));
+    parser.process(app);
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    // A database left by an earlier build may know of specs that are gone
+    const QString output = parser.positionalArguments().first();
+    const QString dbPath = output + QStringLiteral(".db");
+    QFile::remove(dbPath);
+    LanguageManager::setDatabasePath(dbPath);
+    LanguageManager::setSpecsDirectories({ QStringLiteral(SOURCE_LANGUAGE_PATH) });
+
+    // Languages can only be found once the database is up to date
+    LanguageManager *lManager = LanguageManager::getInstance();
+    QEventLoop loop;
+    QObject::connect(lManager, &LanguageManager::dbUpdated, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    // Sorted, so that the output only changes along with the specs
+    const QDir specsDir(QStringLiteral(SOURCE_LANGUAGE_PATH));
+    QStringList specs;
+    const QFileInfoList files =
+        specsDir.entryInfoList({ QStringLiteral("*.lang") }, QDir::Files, QDir::Name);
+    for (const QFileInfo &file : files)
+        specs.append(file.filePath());
+
+    const bool written = writeSource(output, specs);
+
+    lManager->deleteLater();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    return written ? 0 : 1;
+}